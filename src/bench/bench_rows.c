@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../s21_string.h"
+
+/* Масштабирование s21_format_rows_parallel: время форматирования таблицы
+при 1, 2, 4, ... потоках (до числа процессоров или второго аргумента) и
+ускорение относительно одного потока. Первый аргумент — число строк. */
+
+#define REPEATS 3
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+  s21_size_t rows = argc > 1 ? strtoul(argv[1], S21_NULL, 10) : 2000000;
+  long max_threads = argc > 2 ? atol(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+  if (max_threads < 1) {
+    max_threads = 1;
+  }
+
+  // строки разной длины, чтобы кускам доставалось неравное количество работы
+  static const char* words[] = {"x", "lorem", "ipsum dolor sit amet",
+                                "consectetur adipiscing elit, sed do eiusmod "
+                                "tempor incididunt ut labore"};
+  long* ids = malloc(rows * sizeof(long));
+  double* prices = malloc(rows * sizeof(double));
+  const char** names = malloc(rows * sizeof(char*));
+  s21_size_t* offsets = malloc((rows + 1) * sizeof(s21_size_t));
+  s21_size_t* expected_offsets = malloc((rows + 1) * sizeof(s21_size_t));
+  s21_size_t size = rows * 128;
+  char* out = malloc(size);
+  char* expected = malloc(size);
+  if (!ids || !prices || !names || !offsets || !expected_offsets || !out ||
+      !expected) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  srand(1);
+  for (s21_size_t i = 0; i < rows; i++) {
+    ids[i] = rand() - RAND_MAX / 2;
+    prices[i] = rand() / 1000.0;
+    names[i] = words[rand() % 4 * (rand() % 8 == 0)];
+  }
+  s21_column columns[] = {{.type = S21_COLUMN_LONG, .longs = ids},
+                          {.type = S21_COLUMN_STRING, .strings = names},
+                          {.type = S21_COLUMN_DOUBLE, .doubles = prices},
+                          {.type = S21_COLUMN_LONG, .longs = ids}};
+  s21_format* format = s21_format_compile("%d,\"%s\",%.3f,%x\n");
+  s21_format_rows(expected, size, format, columns, rows, expected_offsets);
+
+  printf("%lu rows, %lu bytes\n", rows, expected_offsets[rows]);
+  printf("threads      ms   Mrows/s  speedup\n");
+  double single = 0;
+  for (long threads = 1; threads <= max_threads;
+       threads = threads * 2 > max_threads && threads < max_threads
+                     ? max_threads
+                     : threads * 2) {
+    double best = 0;
+    for (int i = 0; i < REPEATS; i++) {
+      double start = now();
+      s21_format_rows_parallel(out, size, format, columns, rows, offsets,
+                               (int)threads);
+      double time = now() - start;
+      if (i == 0 || time < best) {
+        best = time;
+      }
+    }
+    if (memcmp(out, expected, expected_offsets[rows] + 1) != 0 ||
+        memcmp(offsets, expected_offsets, (rows + 1) * sizeof(*offsets))) {
+      printf("%7ld  output differs\n", threads);
+      return 1;
+    }
+    if (threads == 1) {
+      single = best;
+    }
+    printf("%7ld %7.1f %9.2f %8.2f\n", threads, best * 1e3, rows / best / 1e6,
+           single / best);
+  }
+
+  s21_format_free(format);
+  free(ids);
+  free(prices);
+  free(names);
+  free(offsets);
+  free(expected_offsets);
+  free(out);
+  free(expected);
+  return 0;
+}
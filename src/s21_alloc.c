@@ -0,0 +1,166 @@
+#include <stdlib.h>
+
+#include "s21_string.h"
+
+/* Распределители памяти для функций, возвращающих новые строки
+(s21_to_upper, s21_insert, s21_trim и их варианты). По умолчанию — куча
+(malloc/free), так что результат, как и раньше, освобождается через free.
+Поток может установить свой распределитель, а варианты *_with принимают его
+явно. */
+
+static void* heap_alloc(void* ctx, s21_size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void heap_free(void* ctx, void* ptr) {
+  (void)ctx;
+  free(ptr);
+}
+
+static const s21_allocator heap_allocator = {heap_alloc, heap_free,
+                                             S21_NULL};
+
+static _Thread_local const s21_allocator* thread_allocator = S21_NULL;
+
+const s21_allocator* s21_default_allocator(void) { return &heap_allocator; }
+
+const s21_allocator* s21_thread_allocator(void) {
+  return thread_allocator ? thread_allocator : &heap_allocator;
+}
+
+/* Устанавливает распределитель текущего потока (S21_NULL — куча) и
+возвращает прежний, чтобы его можно было восстановить. */
+const s21_allocator* s21_set_thread_allocator(const s21_allocator* allocator) {
+  const s21_allocator* previous = s21_thread_allocator();
+  thread_allocator = allocator;
+  return previous;
+}
+
+void* s21_allocate(const s21_allocator* allocator, s21_size_t size) {
+  if (allocator == S21_NULL) {
+    allocator = s21_thread_allocator();
+  }
+  return allocator->alloc(allocator->ctx, size);
+}
+
+void s21_deallocate(const s21_allocator* allocator, void* ptr) {
+  if (allocator == S21_NULL) {
+    allocator = s21_thread_allocator();
+  }
+  if (ptr && allocator->free) {
+    allocator->free(allocator->ctx, ptr);
+  }
+}
+
+/* Арена: память выдаётся сдвигом указателя внутри блока, отдельные объекты
+не освобождаются. s21_arena_reset возвращает арену в начало одним действием;
+блоки, кроме последнего (самого большого), при этом отдаются куче. */
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_BLOCK 4096
+#define ARENA_MAX_SIZE ((s21_size_t)-1)
+
+struct s21_arena_block {
+  struct s21_arena_block* prev;
+  s21_size_t size;  // размер данных после заголовка
+};
+
+// заголовок блока занимает целое число выравниваний
+#define BLOCK_HEADER                                                  \
+  ((sizeof(struct s21_arena_block) + ARENA_ALIGN - 1) / ARENA_ALIGN * \
+   ARENA_ALIGN)
+
+static void* arena_alloc(void* ctx, s21_size_t size) {
+  return s21_arena_alloc((s21_arena*)ctx, size);
+}
+
+void s21_arena_init(s21_arena* arena, s21_size_t block_size) {
+  arena->allocator.alloc = arena_alloc;
+  arena->allocator.free = S21_NULL;
+  arena->allocator.ctx = arena;
+  arena->block = S21_NULL;
+  arena->pos = S21_NULL;
+  arena->end = S21_NULL;
+  arena->block_size = block_size < ARENA_MIN_BLOCK ? ARENA_MIN_BLOCK
+                                                   : block_size;
+}
+
+static int arena_grow(s21_arena* arena, s21_size_t size) {
+  int status = -1;
+  s21_size_t data_size = arena->block_size;
+
+  // следующий блок вдвое больше и вмещает запрос
+  if (arena->block && arena->block->size * 2 > data_size &&
+      arena->block->size <= ARENA_MAX_SIZE / 2) {
+    data_size = arena->block->size * 2;
+  }
+  if (data_size < size) {
+    data_size = size;
+  }
+
+  struct s21_arena_block* block = S21_NULL;
+  if (data_size <= ARENA_MAX_SIZE - BLOCK_HEADER) {
+    block = malloc(BLOCK_HEADER + data_size);
+  }
+  if (block) {
+    block->prev = arena->block;
+    block->size = data_size;
+    arena->block = block;
+    arena->pos = (char*)block + BLOCK_HEADER;
+    arena->end = arena->pos + data_size;
+    status = 0;
+  }
+
+  return status;
+}
+
+/* size байтов, выровненных на 16; S21_NULL, если не хватило памяти. Запрос
+нулевого размера получает собственный адрес, как у malloc(1). */
+void* s21_arena_alloc(s21_arena* arena, s21_size_t size) {
+  void* result = S21_NULL;
+  size = size == 0 ? ARENA_ALIGN
+                   : (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+  // size == 0 здесь значит, что округление переполнилось
+  if (size != 0 && ((s21_size_t)(arena->end - arena->pos) >= size ||
+                    arena_grow(arena, size) == 0)) {
+    result = arena->pos;
+    arena->pos += size;
+  }
+
+  return result;
+}
+
+/* Освобождает всё, выделенное из арены; последний блок остаётся для
+следующих запросов. */
+void s21_arena_reset(s21_arena* arena) {
+  struct s21_arena_block* block = arena->block;
+
+  if (block) {
+    struct s21_arena_block* prev = block->prev;
+    while (prev) {
+      struct s21_arena_block* next = prev->prev;
+      free(prev);
+      prev = next;
+    }
+    block->prev = S21_NULL;
+    arena->pos = (char*)block + BLOCK_HEADER;
+    arena->end = arena->pos + block->size;
+  }
+}
+
+void s21_arena_destroy(s21_arena* arena) {
+  s21_arena_reset(arena);
+  free(arena->block);
+  arena->block = S21_NULL;
+  arena->pos = S21_NULL;
+  arena->end = S21_NULL;
+}
+
+/* Распределитель, выделяющий из арены. Он указывает на саму структуру
+arena, поэтому после копирования арены его нужно получить заново. */
+const s21_allocator* s21_arena_allocator(s21_arena* arena) {
+  arena->allocator.ctx = arena;
+  return &arena->allocator;
+}
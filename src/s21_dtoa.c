@@ -0,0 +1,1345 @@
+#include <float.h>
+#include <math.h>
+
+#include "s21_dtoa.h"
+
+/* Точные цифры (s21_decimal_exact). Целая часть числа сразу строится по
+основанию 10^9: мантисса, записанная словами по девять цифр, умножается на
+2^29 столько раз, сколько требует показатель. Дробная часть frac / 2^bits
+даёт девять цифр за шаг: умножение на 10^9 = 5^9 * 2^9 — это умножение frac
+на 5^9 и уменьшение bits на 9, так что frac растёт только вместе с уже
+найденными цифрами и ведущие нули маленьких чисел почти ничего не стоят.
+Цифры пишутся, пока их не наберётся want; есть ли за ними ненулевые,
+сообщает sticky. */
+
+#define CHUNK 1000000000U  // 10^9
+#define CHUNK_DIGITS 9
+#define CHUNK_POW5 1953125U  // 5^9
+// наибольшая степень пятёрки в 32 битах
+#define POW5_STEP 13
+#define POW5_STEP_VALUE 1220703125U  // 5^13
+
+// длина мантиссы, которую различает s21_float_split
+#define MANT_BITS (LDBL_MANT_DIG < 64 ? LDBL_MANT_DIG : 64)
+// слова по 10^9 для целой части LDBL_MAX
+#define INTEGER_WORDS ((LDBL_MAX_10_EXP + 1) / CHUNK_DIGITS + 3)
+// 32-битные слова для дроби самого маленького long double (и 30 бит запаса)
+#define FRACTION_LIMBS ((LDBL_MANT_DIG - LDBL_MIN_EXP + 30) / 32 + 2)
+
+static int bit_width(unsigned long value) {
+#if defined(__GNUC__)
+  return value ? (int)(sizeof(value) * 8) - __builtin_clzl(value) : 0;
+#else
+  int bits = 0;
+  for (; value; value >>= 1) {
+    bits++;
+  }
+  return bits;
+#endif
+}
+
+static int trailing_zeros(unsigned long value) {
+#if defined(__GNUC__)
+  return __builtin_ctzl(value);
+#else
+  int zeros = 0;
+  for (; (value & 1) == 0; value >>= 1) {
+    zeros++;
+  }
+  return zeros;
+#endif
+}
+
+// floor(e * log10(2)) для |e| < 2^20
+static int floor_log10_pow2(int e) {
+  // log10(2) * 2^32, округлено вниз
+  long long scaled = (long long)e * 1292913986LL;
+  return (int)(scaled >= 0 ? scaled >> 32 : -((-scaled + 0xFFFFFFFFLL) >> 32));
+}
+
+/* Раскладывает конечное число: |value| = mant * 2^exp2, где mant нечётна
+(или равна нулю, тогда и exp2 = 0). Аргументы double разбираются по битам,
+long double — через frexpl. */
+int s21_float_split(long double value, bool long_double, unsigned long* mant) {
+  unsigned long m = 0;
+  int exp2 = 0;
+
+  if (!long_double) {
+    union {
+      double d;
+      unsigned long bits;
+    } pun = {(double)value};
+    int biased = (int)((pun.bits >> 52) & 0x7FF);
+    m = pun.bits & ((1UL << 52) - 1);
+    if (biased == 0) {
+      exp2 = -1074;
+    } else {
+      m |= 1UL << 52;
+      exp2 = biased - 1075;
+    }
+  } else {
+    long double fraction = frexpl(fabsl(value), &exp2);
+    m = (unsigned long)ldexpl(fraction, MANT_BITS);
+    exp2 -= MANT_BITS;
+  }
+
+  if (m == 0) {
+    exp2 = 0;
+  } else {
+    int zeros = trailing_zeros(m);
+    m >>= zeros;
+    exp2 += zeros;
+  }
+  *mant = m;
+  return exp2;
+}
+
+/* Число цифр целой части mant * 2^exp2 (точнее, показатель point из
+s21_decimal) — или на единицу больше. */
+int s21_decimal_point_bound(unsigned long mant, int exp2) {
+  int bound = 1;
+  if (mant) {
+    // значение меньше 2^(exp2 + bit_width(mant))
+    bound = floor_log10_pow2(exp2 + bit_width(mant)) + 1;
+  }
+  return bound;
+}
+
+// не меньше числа значащих цифр точного десятичного представления
+int s21_decimal_digits_bound(unsigned long mant, int exp2) {
+  return s21_decimal_point_bound(mant, exp2) + (exp2 < 0 ? -exp2 : 0);
+}
+
+static int chunk_width(unsigned chunk) {
+  int width = 1;
+  for (; chunk >= 10; chunk /= 10) {
+    width++;
+  }
+  return width;
+}
+
+// дописывает width последних цифр chunk, пока их меньше want
+static void push_chunk(s21_decimal* dec, unsigned chunk, int width, int want) {
+  char text[CHUNK_DIGITS];
+  for (int i = width - 1; i >= 0; i--) {
+    text[i] = (char)('0' + chunk % 10);
+    chunk /= 10;
+  }
+  for (int i = 0; i < width; i++) {
+    if (dec->count < want) {
+      dec->digits[dec->count++] = text[i];
+    } else if (text[i] != '0') {
+      dec->sticky = true;
+    }
+  }
+}
+
+// первая значащая группа: её ведущие нули не пишутся
+static void push_leading_chunk(s21_decimal* dec, unsigned chunk, int want) {
+  int width = chunk_width(chunk);
+  dec->point -= CHUNK_DIGITS - width;
+  push_chunk(dec, chunk, width, want);
+}
+
+// цифры целого mant * 2^exp2 (mant != 0, exp2 >= 0)
+static void integer_digits(s21_decimal* dec, unsigned long mant, int exp2,
+                           int want) {
+  unsigned words[INTEGER_WORDS];  // младшие слова — в начале
+  int n = 0;
+
+  for (; mant; mant /= CHUNK) {
+    words[n++] = (unsigned)(mant % CHUNK);
+  }
+  while (exp2 > 0) {
+    int shift = exp2 < 29 ? exp2 : 29;
+    unsigned carry = 0;
+    for (int i = 0; i < n; i++) {
+      unsigned long x = ((unsigned long)words[i] << shift) + carry;
+      words[i] = (unsigned)(x % CHUNK);
+      carry = (unsigned)(x / CHUNK);
+    }
+    if (carry) {
+      words[n++] = carry;
+    }
+    exp2 -= shift;
+  }
+
+  dec->point = CHUNK_DIGITS * n;
+  push_leading_chunk(dec, words[n - 1], want);
+  for (int i = n - 2; i >= 0; i--) {
+    if (dec->count < want) {
+      push_chunk(dec, words[i], CHUNK_DIGITS, want);
+    } else if (words[i]) {
+      dec->sticky = true;
+    }
+  }
+}
+
+// 5^k для k < POW5_STEP
+static const unsigned small_pow5[POW5_STEP] = {
+    1,     5,      25,      125,      625,      3125,     15625,
+    78125, 390625, 1953125, 9765625, 48828125, 244140625};
+
+// умножает n-словное число на m, возвращает новое число слов
+static int big_mul(unsigned* limbs, int n, unsigned m) {
+  unsigned carry = 0;
+  for (int i = 0; i < n; i++) {
+    unsigned long x = (unsigned long)limbs[i] * m + carry;
+    limbs[i] = (unsigned)x;
+    carry = (unsigned)(x >> 32);
+  }
+  if (carry) {
+    limbs[n++] = carry;
+  }
+  return n;
+}
+
+/* Делит n-словное число на 5^k нацело; возвращает, был ли остаток. При
+k = POW5_STEP делитель — константа, и компилятор заменяет деление
+умножением. */
+static bool big_div_pow5(unsigned* limbs, int* n, int k) {
+  unsigned long rem = 0;
+  if (k == POW5_STEP) {
+    for (int i = *n - 1; i >= 0; i--) {
+      unsigned long x = rem << 32 | limbs[i];
+      limbs[i] = (unsigned)(x / POW5_STEP_VALUE);
+      rem = x % POW5_STEP_VALUE;
+    }
+  } else {
+    for (int i = *n - 1; i >= 0; i--) {
+      unsigned long x = rem << 32 | limbs[i];
+      limbs[i] = (unsigned)(x / small_pow5[k]);
+      rem = x % small_pow5[k];
+    }
+  }
+  while (*n > 0 && limbs[*n - 1] == 0) {
+    (*n)--;
+  }
+  return rem != 0;
+}
+
+// цифры дроби frac / 2^bits (frac < 2^bits) после уже записанной целой части
+static void fraction_digits(s21_decimal* dec, unsigned long frac, int bits,
+                            int want) {
+  if (bits <= 60) {
+    // frac * 10 помещается в 64 бита: по одной цифре
+    const unsigned long mask = (1UL << bits) - 1;
+    while (frac && dec->count < want) {
+      frac *= 10;
+      int digit = (int)(frac >> bits);
+      frac &= mask;
+      if (dec->count == 0 && digit == 0) {
+        dec->point--;
+      } else {
+        dec->digits[dec->count++] = (char)('0' + digit);
+      }
+    }
+    if (frac) {
+      dec->sticky = true;
+    }
+  } else {
+    unsigned limbs[FRACTION_LIMBS];  // младшие слова — в начале
+    int n = 0;
+    for (; frac; frac >>= 32) {
+      limbs[n++] = (unsigned)frac;
+    }
+
+    while (n > 0 && dec->count < want) {
+      n = big_mul(limbs, n, CHUNK_POW5);
+      if (bits >= CHUNK_DIGITS) {
+        bits -= CHUNK_DIGITS;
+      } else {
+        // дробь меньше 2^bits < 2^9: результат — одно слово меньше 10^9
+        limbs[0] <<= CHUNK_DIGITS - bits;
+        bits = 0;
+      }
+
+      // целая часть (меньше 10^9) — следующие девять цифр
+      int word = bits / 32;
+      int shift = bits % 32;
+      unsigned chunk = 0;
+      if (word < n) {
+        unsigned long x = limbs[word];
+        if (word + 1 < n) {
+          x |= (unsigned long)limbs[word + 1] << 32;
+        }
+        chunk = (unsigned)(x >> shift);
+        limbs[word] &= (1U << shift) - 1;
+        n = word + 1;
+        while (n > 0 && limbs[n - 1] == 0) {
+          n--;
+        }
+      }
+
+      if (dec->count > 0) {
+        push_chunk(dec, chunk, CHUNK_DIGITS, want);
+      } else if (chunk) {
+        push_leading_chunk(dec, chunk, want);
+      } else {
+        dec->point -= CHUNK_DIGITS;
+      }
+    }
+    if (n > 0) {
+      dec->sticky = true;
+    }
+  }
+}
+
+/* Короткий путь для очень больших и очень маленьких чисел, когда нужно не
+больше 18 цифр: они получаются сразу как одно целое q = floor(value * 10^s),
+где s подобран так, чтобы в q было want или want + 1 цифр. Вместо всех цифр
+целой части (или всех ведущих нулей дроби) считается только
+mant * 5^s * 2^(exp2 + s) — или частное от деления на 5^-s. */
+static void scaled_digits(s21_decimal* dec, unsigned long mant, int exp2,
+                          int want) {
+  unsigned limbs[FRACTION_LIMBS];  // младшие слова — в начале
+  int n = 0;
+  int s = want + 1 - s21_decimal_point_bound(mant, exp2);
+  int offset = exp2 + s;  // показатель двойки после умножения на 5^s
+  bool sticky = false;
+
+  if (s >= 0) {
+    for (; mant; mant >>= 32) {
+      limbs[n++] = (unsigned)mant;
+    }
+    for (int k = s; k > 0; k -= POW5_STEP) {
+      n = big_mul(limbs, n, k >= POW5_STEP ? POW5_STEP_VALUE : small_pow5[k]);
+    }
+  } else if (offset >= 0) {
+    // mant * 2^offset: нулевые младшие слова и сдвинутая мантисса
+    int words = offset / 32;
+    unsigned long low = mant << (offset % 32);
+    unsigned long high = offset % 32 ? mant >> (64 - offset % 32) : 0;
+    for (; n < words; n++) {
+      limbs[n] = 0;
+    }
+    limbs[n++] = (unsigned)low;
+    limbs[n++] = (unsigned)(low >> 32);
+    limbs[n++] = (unsigned)high;
+    offset = 0;
+    while (limbs[n - 1] == 0) {
+      n--;
+    }
+  } else {
+    // целая часть меньше 2^64: сдвиг сразу, отброшенные биты — в sticky
+    unsigned long shifted = offset > -64 ? mant >> -offset : 0;
+    sticky = offset > -64 ? (shifted << -offset) != mant : true;
+    for (; shifted; shifted >>= 32) {
+      limbs[n++] = (unsigned)shifted;
+    }
+    offset = 0;
+  }
+  for (int k = -s; k > 0; k -= POW5_STEP) {
+    sticky |= big_div_pow5(limbs, &n, k < POW5_STEP ? k : POW5_STEP);
+  }
+
+  // q = число * 2^offset; оно меньше 10^(want + 1) <= 10^19
+  unsigned long q = 0;
+  if (offset >= 0) {
+    q = n > 0 ? limbs[0] : 0;
+    q |= n > 1 ? (unsigned long)limbs[1] << 32 : 0;
+    q <<= offset;
+  } else {
+    int word = -offset / 32;
+    int bit = -offset % 32;
+    for (int i = 0; i < word && i < n && !sticky; i++) {
+      sticky = limbs[i] != 0;
+    }
+    if (word < n) {
+      sticky |= (limbs[word] & ((1U << bit) - 1)) != 0;
+      unsigned long window = limbs[word];
+      if (word + 1 < n) {
+        window |= (unsigned long)limbs[word + 1] << 32;
+      }
+      q = window >> bit;
+      if (bit > 0 && word + 2 < n) {
+        q |= (unsigned long)limbs[word + 2] << (64 - bit);
+      }
+    }
+  }
+
+  int width = 0;
+  for (unsigned long rest = q; rest; rest /= 10) {
+    width++;
+  }
+  if (width > want) {
+    sticky |= q % 10 != 0;
+    q /= 10;
+    width--;
+    s--;
+  }
+  for (int i = width - 1; i >= 0; i--) {
+    dec->digits[i] = (char)('0' + q % 10);
+    q /= 10;
+  }
+  dec->count = width;
+  dec->point = width - s;
+  dec->sticky = sticky;
+}
+
+/* Первые want значащих цифр mant * 2^exp2 (не меньше одной). В dec->digits
+должно быть место для min(want, s21_decimal_digits_bound(mant, exp2))
+цифр. Ноль — это count = 0 и point = 1. */
+void s21_decimal_exact(s21_decimal* dec, unsigned long mant, int exp2,
+                       int want) {
+  dec->count = 0;
+  dec->point = 0;
+  dec->sticky = false;
+  if (want < 1) {
+    want = 1;
+  }
+
+  // целая часть не помещается в 64 бита или дробь — в быстрый путь
+  bool extreme = exp2 >= 0 ? exp2 + bit_width(mant) > 64 : exp2 <= -64;
+
+  if (mant == 0) {
+    dec->point = 1;
+  } else if (extreme && want <= 18) {
+    scaled_digits(dec, mant, exp2, want);
+  } else if (exp2 >= 0) {
+    integer_digits(dec, mant, exp2, want);
+  } else {
+    int bits = -exp2;
+    if (bits < 64 && mant >> bits) {
+      integer_digits(dec, mant >> bits, 0, want);
+      mant &= (1UL << bits) - 1;
+    }
+    fraction_digits(dec, mant, bits, want);
+  }
+}
+
+/* Оставляет keep значащих цифр, округляя по правилу «половина — к чётному»
+(как printf при обычном режиме округления). При keep <= 0 от числа может
+остаться ноль или единица в разряде выше первой цифры. */
+void s21_decimal_round(s21_decimal* dec, long keep) {
+  if (keep < dec->count) {
+    bool up = false;
+    if (keep >= 0) {
+      char digit = dec->digits[keep];
+      bool tail = dec->sticky;
+      for (long i = keep + 1; i < dec->count && !tail; i++) {
+        tail = dec->digits[i] != '0';
+      }
+      bool odd = keep > 0 && (dec->digits[keep - 1] - '0') % 2 == 1;
+      up = digit > '5' || (digit == '5' && (tail || odd));
+    }
+
+    dec->count = keep > 0 ? (int)keep : 0;
+    dec->sticky = false;
+    if (up) {
+      int i = dec->count - 1;
+      while (i >= 0 && dec->digits[i] == '9') {
+        i--;
+      }
+      if (i < 0) {
+        dec->digits[0] = '1';
+        dec->count = 1;
+        dec->point++;
+      } else {
+        dec->digits[i]++;
+        dec->count = i + 1;
+      }
+    }
+  }
+}
+
+/* Кратчайшие цифры (s21_decimal_shortest) — алгоритм Ryu (Ulf Adams, 2018):
+среди десятичных чисел, которые при чтении дают тот же double, выбирается
+самое короткое, а из равных по длине — ближайшее к точному значению. Границы
+интервала округления умножаются на степени пятёрки из таблиц ниже (125 бит
+на степень), после чего лишние цифры отбрасываются делением на 10.
+
+pow5_inv_split[q] = floor(2^(bit_width(5^q) - 1 + 125) / 5^q) + 1,
+pow5_split[i] = 5^i, сдвинутое так, чтобы занимать ровно 125 бит; каждое
+записано как {младшие 64 бита, старшие}. */
+
+#define POW5_INV_BITCOUNT 125
+#define POW5_BITCOUNT 125
+
+static const unsigned long pow5_inv_split[342][2] = {
+    {1UL, 2305843009213693952UL},
+    {11068046444225730970UL, 1844674407370955161UL},
+    {5165088340638674453UL, 1475739525896764129UL},
+    {7821419487252849886UL, 1180591620717411303UL},
+    {8824922364862649494UL, 1888946593147858085UL},
+    {7059937891890119595UL, 1511157274518286468UL},
+    {13026647942995916322UL, 1208925819614629174UL},
+    {9774590264567735146UL, 1934281311383406679UL},
+    {11509021026396098440UL, 1547425049106725343UL},
+    {16585914450600699399UL, 1237940039285380274UL},
+    {15469416676735388068UL, 1980704062856608439UL},
+    {16064882156130220778UL, 1584563250285286751UL},
+    {9162556910162266299UL, 1267650600228229401UL},
+    {7281393426775805432UL, 2028240960365167042UL},
+    {16893161185646375315UL, 1622592768292133633UL},
+    {2446482504291369283UL, 1298074214633706907UL},
+    {7603720821608101175UL, 2076918743413931051UL},
+    {2393627842544570617UL, 1661534994731144841UL},
+    {16672297533003297786UL, 1329227995784915872UL},
+    {11918280793837635165UL, 2126764793255865396UL},
+    {5845275820328197809UL, 1701411834604692317UL},
+    {15744267100488289217UL, 1361129467683753853UL},
+    {3054734472329800808UL, 2177807148294006166UL},
+    {17201182836831481939UL, 1742245718635204932UL},
+    {6382248639981364905UL, 1393796574908163946UL},
+    {2832900194486363201UL, 2230074519853062314UL},
+    {5955668970331000884UL, 1784059615882449851UL},
+    {1075186361522890384UL, 1427247692705959881UL},
+    {12788344622662355584UL, 2283596308329535809UL},
+    {13920024512871794791UL, 1826877046663628647UL},
+    {3757321980813615186UL, 1461501637330902918UL},
+    {10384555214134712795UL, 1169201309864722334UL},
+    {5547241898389809503UL, 1870722095783555735UL},
+    {4437793518711847602UL, 1496577676626844588UL},
+    {10928932444453298728UL, 1197262141301475670UL},
+    {17486291911125277965UL, 1915619426082361072UL},
+    {6610335899416401726UL, 1532495540865888858UL},
+    {12666966349016942027UL, 1225996432692711086UL},
+    {12888448528943286597UL, 1961594292308337738UL},
+    {17689456452638449924UL, 1569275433846670190UL},
+    {14151565162110759939UL, 1255420347077336152UL},
+    {7885109000409574610UL, 2008672555323737844UL},
+    {9997436015069570011UL, 1606938044258990275UL},
+    {7997948812055656009UL, 1285550435407192220UL},
+    {12796718099289049614UL, 2056880696651507552UL},
+    {2858676849947419045UL, 1645504557321206042UL},
+    {13354987924183666206UL, 1316403645856964833UL},
+    {17678631863951955605UL, 2106245833371143733UL},
+    {3074859046935833515UL, 1684996666696914987UL},
+    {13527933681774397782UL, 1347997333357531989UL},
+    {10576647446613305481UL, 2156795733372051183UL},
+    {15840015586774465031UL, 1725436586697640946UL},
+    {8982663654677661702UL, 1380349269358112757UL},
+    {18061610662226169046UL, 2208558830972980411UL},
+    {10759939715039024913UL, 1766847064778384329UL},
+    {12297300586773130254UL, 1413477651822707463UL},
+    {15986332124095098083UL, 2261564242916331941UL},
+    {9099716884534168143UL, 1809251394333065553UL},
+    {14658471137111155161UL, 1447401115466452442UL},
+    {4348079280205103483UL, 1157920892373161954UL},
+    {14335624477811986218UL, 1852673427797059126UL},
+    {7779150767507678651UL, 1482138742237647301UL},
+    {2533971799264232598UL, 1185710993790117841UL},
+    {15122401323048503126UL, 1897137590064188545UL},
+    {12097921058438802501UL, 1517710072051350836UL},
+    {5988988032009131678UL, 1214168057641080669UL},
+    {16961078480698431330UL, 1942668892225729070UL},
+    {13568862784558745064UL, 1554135113780583256UL},
+    {7165741412905085728UL, 1243308091024466605UL},
+    {11465186260648137165UL, 1989292945639146568UL},
+    {16550846638002330379UL, 1591434356511317254UL},
+    {16930026125143774626UL, 1273147485209053803UL},
+    {4951948911778577463UL, 2037035976334486086UL},
+    {272210314680951647UL, 1629628781067588869UL},
+    {3907117066486671641UL, 1303703024854071095UL},
+    {6251387306378674625UL, 2085924839766513752UL},
+    {16069156289328670670UL, 1668739871813211001UL},
+    {9165976216721026213UL, 1334991897450568801UL},
+    {7286864317269821294UL, 2135987035920910082UL},
+    {16897537898041588005UL, 1708789628736728065UL},
+    {13518030318433270404UL, 1367031702989382452UL},
+    {6871453250525591353UL, 2187250724783011924UL},
+    {9186511415162383406UL, 1749800579826409539UL},
+    {11038557946871817048UL, 1399840463861127631UL},
+    {10282995085511086630UL, 2239744742177804210UL},
+    {8226396068408869304UL, 1791795793742243368UL},
+    {13959814484210916090UL, 1433436634993794694UL},
+    {11267656730511734774UL, 2293498615990071511UL},
+    {5324776569667477496UL, 1834798892792057209UL},
+    {7949170070475892320UL, 1467839114233645767UL},
+    {17427382500606444826UL, 1174271291386916613UL},
+    {5747719112518849781UL, 1878834066219066582UL},
+    {15666221734240810795UL, 1503067252975253265UL},
+    {12532977387392648636UL, 1202453802380202612UL},
+    {5295368560860596524UL, 1923926083808324180UL},
+    {4236294848688477220UL, 1539140867046659344UL},
+    {7078384693692692099UL, 1231312693637327475UL},
+    {11325415509908307358UL, 1970100309819723960UL},
+    {9060332407926645887UL, 1576080247855779168UL},
+    {14626963555825137356UL, 1260864198284623334UL},
+    {12335095245094488799UL, 2017382717255397335UL},
+    {9868076196075591040UL, 1613906173804317868UL},
+    {15273158586344293478UL, 1291124939043454294UL},
+    {13369007293925138595UL, 2065799902469526871UL},
+    {7005857020398200553UL, 1652639921975621497UL},
+    {16672732060544291412UL, 1322111937580497197UL},
+    {11918976037903224966UL, 2115379100128795516UL},
+    {5845832015580669650UL, 1692303280103036413UL},
+    {12055363241948356366UL, 1353842624082429130UL},
+    {841837113407818570UL, 2166148198531886609UL},
+    {4362818505468165179UL, 1732918558825509287UL},
+    {14558301248600263113UL, 1386334847060407429UL},
+    {12225235553534690011UL, 2218135755296651887UL},
+    {2401490813343931363UL, 1774508604237321510UL},
+    {1921192650675145090UL, 1419606883389857208UL},
+    {17831303500047873437UL, 2271371013423771532UL},
+    {6886345170554478103UL, 1817096810739017226UL},
+    {1819727321701672159UL, 1453677448591213781UL},
+    {16213177116328979020UL, 1162941958872971024UL},
+    {14873036941900635463UL, 1860707134196753639UL},
+    {15587778368262418694UL, 1488565707357402911UL},
+    {8780873879868024632UL, 1190852565885922329UL},
+    {2981351763563108441UL, 1905364105417475727UL},
+    {13453127855076217722UL, 1524291284333980581UL},
+    {7073153469319063855UL, 1219433027467184465UL},
+    {11317045550910502167UL, 1951092843947495144UL},
+    {12742985255470312057UL, 1560874275157996115UL},
+    {10194388204376249646UL, 1248699420126396892UL},
+    {1553625868034358140UL, 1997919072202235028UL},
+    {8621598323911307159UL, 1598335257761788022UL},
+    {17965325103354776697UL, 1278668206209430417UL},
+    {13987124906400001422UL, 2045869129935088668UL},
+    {121653480894270168UL, 1636695303948070935UL},
+    {97322784715416134UL, 1309356243158456748UL},
+    {14913111714512307107UL, 2094969989053530796UL},
+    {8241140556867935363UL, 1675975991242824637UL},
+    {17660958889720079260UL, 1340780792994259709UL},
+    {17189487779326395846UL, 2145249268790815535UL},
+    {13751590223461116677UL, 1716199415032652428UL},
+    {18379969808252713988UL, 1372959532026121942UL},
+    {14650556434236701088UL, 2196735251241795108UL},
+    {652398703163629901UL, 1757388200993436087UL},
+    {11589965406756634890UL, 1405910560794748869UL},
+    {7475898206584884855UL, 2249456897271598191UL},
+    {2291369750525997561UL, 1799565517817278553UL},
+    {9211793429904618695UL, 1439652414253822842UL},
+    {18428218302589300235UL, 2303443862806116547UL},
+    {7363877012587619542UL, 1842755090244893238UL},
+    {13269799239553916280UL, 1474204072195914590UL},
+    {10615839391643133024UL, 1179363257756731672UL},
+    {2227947767661371545UL, 1886981212410770676UL},
+    {16539753473096738529UL, 1509584969928616540UL},
+    {13231802778477390823UL, 1207667975942893232UL},
+    {6413489186596184024UL, 1932268761508629172UL},
+    {16198837793502678189UL, 1545815009206903337UL},
+    {5580372605318321905UL, 1236652007365522670UL},
+    {8928596168509315048UL, 1978643211784836272UL},
+    {18210923379033183008UL, 1582914569427869017UL},
+    {7190041073742725760UL, 1266331655542295214UL},
+    {436019273762630246UL, 2026130648867672343UL},
+    {7727513048493924843UL, 1620904519094137874UL},
+    {9871359253537050198UL, 1296723615275310299UL},
+    {4726128361433549347UL, 2074757784440496479UL},
+    {7470251503888749801UL, 1659806227552397183UL},
+    {13354898832594820487UL, 1327844982041917746UL},
+    {13989140502667892133UL, 2124551971267068394UL},
+    {14880661216876224029UL, 1699641577013654715UL},
+    {11904528973500979224UL, 1359713261610923772UL},
+    {4289851098633925465UL, 2175541218577478036UL},
+    {18189276137874781665UL, 1740432974861982428UL},
+    {3483374466074094362UL, 1392346379889585943UL},
+    {1884050330976640656UL, 2227754207823337509UL},
+    {5196589079523222848UL, 1782203366258670007UL},
+    {15225317707844309248UL, 1425762693006936005UL},
+    {5913764258841343181UL, 2281220308811097609UL},
+    {8420360221814984868UL, 1824976247048878087UL},
+    {17804334621677718864UL, 1459980997639102469UL},
+    {17932816512084085415UL, 1167984798111281975UL},
+    {10245762345624985047UL, 1868775676978051161UL},
+    {4507261061758077715UL, 1495020541582440929UL},
+    {7295157664148372495UL, 1196016433265952743UL},
+    {7982903447895485668UL, 1913626293225524389UL},
+    {10075671573058298858UL, 1530901034580419511UL},
+    {4371188443704728763UL, 1224720827664335609UL},
+    {14372599139411386667UL, 1959553324262936974UL},
+    {15187428126271019657UL, 1567642659410349579UL},
+    {15839291315758726049UL, 1254114127528279663UL},
+    {3206773216762499739UL, 2006582604045247462UL},
+    {13633465017635730761UL, 1605266083236197969UL},
+    {14596120828850494932UL, 1284212866588958375UL},
+    {4907049252451240275UL, 2054740586542333401UL},
+    {236290587219081897UL, 1643792469233866721UL},
+    {14946427728742906810UL, 1315033975387093376UL},
+    {16535586736504830250UL, 2104054360619349402UL},
+    {5849771759720043554UL, 1683243488495479522UL},
+    {15747863852001765813UL, 1346594790796383617UL},
+    {10439186904235184007UL, 2154551665274213788UL},
+    {15730047152871967852UL, 1723641332219371030UL},
+    {12584037722297574282UL, 1378913065775496824UL},
+    {9066413911450387881UL, 2206260905240794919UL},
+    {10942479943902220628UL, 1765008724192635935UL},
+    {8753983955121776503UL, 1412006979354108748UL},
+    {10317025513452932081UL, 2259211166966573997UL},
+    {874922781278525018UL, 1807368933573259198UL},
+    {8078635854506640661UL, 1445895146858607358UL},
+    {13841606313089133175UL, 1156716117486885886UL},
+    {14767872471458792434UL, 1850745787979017418UL},
+    {746251532941302978UL, 1480596630383213935UL},
+    {597001226353042382UL, 1184477304306571148UL},
+    {15712597221132509104UL, 1895163686890513836UL},
+    {8880728962164096960UL, 1516130949512411069UL},
+    {10793931984473187891UL, 1212904759609928855UL},
+    {17270291175157100626UL, 1940647615375886168UL},
+    {2748186495899949531UL, 1552518092300708935UL},
+    {2198549196719959625UL, 1242014473840567148UL},
+    {18275073973719576693UL, 1987223158144907436UL},
+    {10930710364233751031UL, 1589778526515925949UL},
+    {12433917106128911148UL, 1271822821212740759UL},
+    {8826220925580526867UL, 2034916513940385215UL},
+    {7060976740464421494UL, 1627933211152308172UL},
+    {16716827836597268165UL, 1302346568921846537UL},
+    {11989529279587987770UL, 2083754510274954460UL},
+    {9591623423670390216UL, 1667003608219963568UL},
+    {15051996368420132820UL, 1333602886575970854UL},
+    {13015147745246481542UL, 2133764618521553367UL},
+    {3033420566713364587UL, 1707011694817242694UL},
+    {6116085268112601993UL, 1365609355853794155UL},
+    {9785736428980163188UL, 2184974969366070648UL},
+    {15207286772667951197UL, 1747979975492856518UL},
+    {1097782973908629988UL, 1398383980394285215UL},
+    {1756452758253807981UL, 2237414368630856344UL},
+    {5094511021344956708UL, 1789931494904685075UL},
+    {4075608817075965366UL, 1431945195923748060UL},
+    {6520974107321544586UL, 2291112313477996896UL},
+    {1527430471115325346UL, 1832889850782397517UL},
+    {12289990821117991246UL, 1466311880625918013UL},
+    {17210690286378213644UL, 1173049504500734410UL},
+    {9090360384495590213UL, 1876879207201175057UL},
+    {18340334751822203140UL, 1501503365760940045UL},
+    {14672267801457762512UL, 1201202692608752036UL},
+    {16096930852848599373UL, 1921924308174003258UL},
+    {1809498238053148529UL, 1537539446539202607UL},
+    {12515645034668249793UL, 1230031557231362085UL},
+    {1578287981759648052UL, 1968050491570179337UL},
+    {12330676829633449412UL, 1574440393256143469UL},
+    {13553890278448669853UL, 1259552314604914775UL},
+    {3239480371808320148UL, 2015283703367863641UL},
+    {17348979556414297411UL, 1612226962694290912UL},
+    {6500486015647617283UL, 1289781570155432730UL},
+    {10400777625036187652UL, 2063650512248692368UL},
+    {15699319729512770768UL, 1650920409798953894UL},
+    {16248804598352126938UL, 1320736327839163115UL},
+    {7551343283653851484UL, 2113178124542660985UL},
+    {6041074626923081187UL, 1690542499634128788UL},
+    {12211557331022285596UL, 1352433999707303030UL},
+    {1091747655926105338UL, 2163894399531684849UL},
+    {4562746939482794594UL, 1731115519625347879UL},
+    {7339546366328145998UL, 1384892415700278303UL},
+    {8053925371383123274UL, 2215827865120445285UL},
+    {6443140297106498619UL, 1772662292096356228UL},
+    {12533209867169019542UL, 1418129833677084982UL},
+    {5295740528502789974UL, 2269007733883335972UL},
+    {15304638867027962949UL, 1815206187106668777UL},
+    {4865013464138549713UL, 1452164949685335022UL},
+    {14960057215536570740UL, 1161731959748268017UL},
+    {9178696285890871890UL, 1858771135597228828UL},
+    {14721654658196518159UL, 1487016908477783062UL},
+    {4398626097073393881UL, 1189613526782226450UL},
+    {7037801755317430209UL, 1903381642851562320UL},
+    {5630241404253944167UL, 1522705314281249856UL},
+    {814844308661245011UL, 1218164251424999885UL},
+    {1303750893857992017UL, 1949062802279999816UL},
+    {15800395974054034906UL, 1559250241823999852UL},
+    {5261619149759407279UL, 1247400193459199882UL},
+    {12107939454356961969UL, 1995840309534719811UL},
+    {5997002748743659252UL, 1596672247627775849UL},
+    {8486951013736837725UL, 1277337798102220679UL},
+    {2511075177753209390UL, 2043740476963553087UL},
+    {13076906586428298482UL, 1634992381570842469UL},
+    {14150874083884549109UL, 1307993905256673975UL},
+    {4194654460505726958UL, 2092790248410678361UL},
+    {18113118827372222859UL, 1674232198728542688UL},
+    {3422448617672047318UL, 1339385758982834151UL},
+    {16543964232501006678UL, 2143017214372534641UL},
+    {9545822571258895019UL, 1714413771498027713UL},
+    {15015355686490936662UL, 1371531017198422170UL},
+    {5577825024675947042UL, 2194449627517475473UL},
+    {11840957649224578280UL, 1755559702013980378UL},
+    {16851463748863483271UL, 1404447761611184302UL},
+    {12204946739213931940UL, 2247116418577894884UL},
+    {13453306206113055875UL, 1797693134862315907UL},
+    {3383947335406624054UL, 1438154507889852726UL},
+    {16482362180876329456UL, 2301047212623764361UL},
+    {9496540929959153242UL, 1840837770099011489UL},
+    {11286581558709232917UL, 1472670216079209191UL},
+    {5339916432225476010UL, 1178136172863367353UL},
+    {4854517476818851293UL, 1885017876581387765UL},
+    {3883613981455081034UL, 1508014301265110212UL},
+    {14174937629389795797UL, 1206411441012088169UL},
+    {11611853762797942306UL, 1930258305619341071UL},
+    {5600134195496443521UL, 1544206644495472857UL},
+    {15548153800622885787UL, 1235365315596378285UL},
+    {6430302007287065643UL, 1976584504954205257UL},
+    {16212288050055383484UL, 1581267603963364205UL},
+    {12969830440044306787UL, 1265014083170691364UL},
+    {9683682259845159889UL, 2024022533073106183UL},
+    {15125643437359948558UL, 1619218026458484946UL},
+    {8411165935146048523UL, 1295374421166787957UL},
+    {17147214310975587960UL, 2072599073866860731UL},
+    {10028422634038560045UL, 1658079259093488585UL},
+    {8022738107230848036UL, 1326463407274790868UL},
+    {9147032156827446534UL, 2122341451639665389UL},
+    {11006974540203867551UL, 1697873161311732311UL},
+    {5116230817421183718UL, 1358298529049385849UL},
+    {15564666937357714594UL, 2173277646479017358UL},
+    {1383687105660440706UL, 1738622117183213887UL},
+    {12174996128754083534UL, 1390897693746571109UL},
+    {8411947361780802685UL, 2225436309994513775UL},
+    {6729557889424642148UL, 1780349047995611020UL},
+    {5383646311539713719UL, 1424279238396488816UL},
+    {1235136468979721303UL, 2278846781434382106UL},
+    {15745504434151418335UL, 1823077425147505684UL},
+    {16285752362063044992UL, 1458461940118004547UL},
+    {5649904260166615347UL, 1166769552094403638UL},
+    {5350498001524674232UL, 1866831283351045821UL},
+    {591049586477829062UL, 1493465026680836657UL},
+    {11540886113407994219UL, 1194772021344669325UL},
+    {18673707743239135UL, 1911635234151470921UL},
+    {14772334225162232601UL, 1529308187321176736UL},
+    {8128518565387875758UL, 1223446549856941389UL},
+    {1937583260394870242UL, 1957514479771106223UL},
+    {8928764237799716840UL, 1566011583816884978UL},
+    {14521709019723594119UL, 1252809267053507982UL},
+    {8477339172590109297UL, 2004494827285612772UL},
+    {17849917782297818407UL, 1603595861828490217UL},
+    {6901236596354434079UL, 1282876689462792174UL},
+    {18420676183650915173UL, 2052602703140467478UL},
+    {3668494502695001169UL, 1642082162512373983UL},
+    {10313493231639821582UL, 1313665730009899186UL},
+    {9122891541139893884UL, 2101865168015838698UL},
+    {14677010862395735754UL, 1681492134412670958UL},
+    {673562245690857633UL, 1345193707530136767UL}
+};
+
+static const unsigned long pow5_split[326][2] = {
+    {0UL, 1152921504606846976UL},
+    {0UL, 1441151880758558720UL},
+    {0UL, 1801439850948198400UL},
+    {0UL, 2251799813685248000UL},
+    {0UL, 1407374883553280000UL},
+    {0UL, 1759218604441600000UL},
+    {0UL, 2199023255552000000UL},
+    {0UL, 1374389534720000000UL},
+    {0UL, 1717986918400000000UL},
+    {0UL, 2147483648000000000UL},
+    {0UL, 1342177280000000000UL},
+    {0UL, 1677721600000000000UL},
+    {0UL, 2097152000000000000UL},
+    {0UL, 1310720000000000000UL},
+    {0UL, 1638400000000000000UL},
+    {0UL, 2048000000000000000UL},
+    {0UL, 1280000000000000000UL},
+    {0UL, 1600000000000000000UL},
+    {0UL, 2000000000000000000UL},
+    {0UL, 1250000000000000000UL},
+    {0UL, 1562500000000000000UL},
+    {0UL, 1953125000000000000UL},
+    {0UL, 1220703125000000000UL},
+    {0UL, 1525878906250000000UL},
+    {0UL, 1907348632812500000UL},
+    {0UL, 1192092895507812500UL},
+    {0UL, 1490116119384765625UL},
+    {4611686018427387904UL, 1862645149230957031UL},
+    {9799832789158199296UL, 1164153218269348144UL},
+    {12249790986447749120UL, 1455191522836685180UL},
+    {15312238733059686400UL, 1818989403545856475UL},
+    {14528612397897220096UL, 2273736754432320594UL},
+    {13692068767113150464UL, 1421085471520200371UL},
+    {12503399940464050176UL, 1776356839400250464UL},
+    {15629249925580062720UL, 2220446049250313080UL},
+    {9768281203487539200UL, 1387778780781445675UL},
+    {7598665485932036096UL, 1734723475976807094UL},
+    {274959820560269312UL, 2168404344971008868UL},
+    {9395221924704944128UL, 1355252715606880542UL},
+    {2520655369026404352UL, 1694065894508600678UL},
+    {12374191248137781248UL, 2117582368135750847UL},
+    {14651398557727195136UL, 1323488980084844279UL},
+    {13702562178731606016UL, 1654361225106055349UL},
+    {3293144668132343808UL, 2067951531382569187UL},
+    {18199116482078572544UL, 1292469707114105741UL},
+    {8913837547316051968UL, 1615587133892632177UL},
+    {15753982952572452864UL, 2019483917365790221UL},
+    {12152082354571476992UL, 1262177448353618888UL},
+    {15190102943214346240UL, 1577721810442023610UL},
+    {9764256642163156992UL, 1972152263052529513UL},
+    {17631875447420442880UL, 1232595164407830945UL},
+    {8204786253993389888UL, 1540743955509788682UL},
+    {1032610780636961552UL, 1925929944387235853UL},
+    {2951224747111794922UL, 1203706215242022408UL},
+    {3689030933889743652UL, 1504632769052528010UL},
+    {13834660704216955373UL, 1880790961315660012UL},
+    {17870034976990372916UL, 1175494350822287507UL},
+    {17725857702810578241UL, 1469367938527859384UL},
+    {3710578054803671186UL, 1836709923159824231UL},
+    {26536550077201078UL, 2295887403949780289UL},
+    {11545800389866720434UL, 1434929627468612680UL},
+    {14432250487333400542UL, 1793662034335765850UL},
+    {8816941072311974870UL, 2242077542919707313UL},
+    {17039803216263454053UL, 1401298464324817070UL},
+    {12076381983474541759UL, 1751623080406021338UL},
+    {5872105442488401391UL, 2189528850507526673UL},
+    {15199280947623720629UL, 1368455531567204170UL},
+    {9775729147674874978UL, 1710569414459005213UL},
+    {16831347453020981627UL, 2138211768073756516UL},
+    {1296220121283337709UL, 1336382355046097823UL},
+    {15455333206886335848UL, 1670477943807622278UL},
+    {10095794471753144002UL, 2088097429759527848UL},
+    {6309871544845715001UL, 1305060893599704905UL},
+    {12499025449484531656UL, 1631326116999631131UL},
+    {11012095793428276666UL, 2039157646249538914UL},
+    {11494245889320060820UL, 1274473528905961821UL},
+    {532749306367912313UL, 1593091911132452277UL},
+    {5277622651387278295UL, 1991364888915565346UL},
+    {7910200175544436838UL, 1244603055572228341UL},
+    {14499436237857933952UL, 1555753819465285426UL},
+    {8900923260467641632UL, 1944692274331606783UL},
+    {12480606065433357876UL, 1215432671457254239UL},
+    {10989071563364309441UL, 1519290839321567799UL},
+    {9124653435777998898UL, 1899113549151959749UL},
+    {8008751406574943263UL, 1186945968219974843UL},
+    {5399253239791291175UL, 1483682460274968554UL},
+    {15972438586593889776UL, 1854603075343710692UL},
+    {759402079766405302UL, 1159126922089819183UL},
+    {14784310654990170340UL, 1448908652612273978UL},
+    {9257016281882937117UL, 1811135815765342473UL},
+    {16182956370781059300UL, 2263919769706678091UL},
+    {7808504722524468110UL, 1414949856066673807UL},
+    {5148944884728197234UL, 1768687320083342259UL},
+    {1824495087482858639UL, 2210859150104177824UL},
+    {1140309429676786649UL, 1381786968815111140UL},
+    {1425386787095983311UL, 1727233711018888925UL},
+    {6393419502297367043UL, 2159042138773611156UL},
+    {13219259225790630210UL, 1349401336733506972UL},
+    {16524074032238287762UL, 1686751670916883715UL},
+    {16043406521870471799UL, 2108439588646104644UL},
+    {803757039314269066UL, 1317774742903815403UL},
+    {14839754354425000045UL, 1647218428629769253UL},
+    {4714634887749086344UL, 2059023035787211567UL},
+    {9864175832484260821UL, 1286889397367007229UL},
+    {16941905809032713930UL, 1608611746708759036UL},
+    {2730638187581340797UL, 2010764683385948796UL},
+    {10930020904093113806UL, 1256727927116217997UL},
+    {18274212148543780162UL, 1570909908895272496UL},
+    {4396021111970173586UL, 1963637386119090621UL},
+    {5053356204195052443UL, 1227273366324431638UL},
+    {15540067292098591362UL, 1534091707905539547UL},
+    {14813398096695851299UL, 1917614634881924434UL},
+    {13870059828862294966UL, 1198509146801202771UL},
+    {12725888767650480803UL, 1498136433501503464UL},
+    {15907360959563101004UL, 1872670541876879330UL},
+    {14553786618154326031UL, 1170419088673049581UL},
+    {4357175217410743827UL, 1463023860841311977UL},
+    {10058155040190817688UL, 1828779826051639971UL},
+    {7961007781811134206UL, 2285974782564549964UL},
+    {14199001900486734687UL, 1428734239102843727UL},
+    {13137066357181030455UL, 1785917798878554659UL},
+    {11809646928048900164UL, 2232397248598193324UL},
+    {16604401366885338411UL, 1395248280373870827UL},
+    {16143815690179285109UL, 1744060350467338534UL},
+    {10956397575869330579UL, 2180075438084173168UL},
+    {6847748484918331612UL, 1362547148802608230UL},
+    {17783057643002690323UL, 1703183936003260287UL},
+    {17617136035325974999UL, 2128979920004075359UL},
+    {17928239049719816230UL, 1330612450002547099UL},
+    {17798612793722382384UL, 1663265562503183874UL},
+    {13024893955298202172UL, 2079081953128979843UL},
+    {5834715712847682405UL, 1299426220705612402UL},
+    {16516766677914378815UL, 1624282775882015502UL},
+    {11422586310538197711UL, 2030353469852519378UL},
+    {11750802462513761473UL, 1268970918657824611UL},
+    {10076817059714813937UL, 1586213648322280764UL},
+    {12596021324643517422UL, 1982767060402850955UL},
+    {5566670318688504437UL, 1239229412751781847UL},
+    {2346651879933242642UL, 1549036765939727309UL},
+    {7545000868343941206UL, 1936295957424659136UL},
+    {4715625542714963254UL, 1210184973390411960UL},
+    {5894531928393704067UL, 1512731216738014950UL},
+    {16591536947346905892UL, 1890914020922518687UL},
+    {17287239619732898039UL, 1181821263076574179UL},
+    {16997363506238734644UL, 1477276578845717724UL},
+    {2799960309088866689UL, 1846595723557147156UL},
+    {10973347230035317489UL, 1154122327223216972UL},
+    {13716684037544146861UL, 1442652909029021215UL},
+    {12534169028502795672UL, 1803316136286276519UL},
+    {11056025267201106687UL, 2254145170357845649UL},
+    {18439230838069161439UL, 1408840731473653530UL},
+    {13825666510731675991UL, 1761050914342066913UL},
+    {3447025083132431277UL, 2201313642927583642UL},
+    {6766076695385157452UL, 1375821026829739776UL},
+    {8457595869231446815UL, 1719776283537174720UL},
+    {10571994836539308519UL, 2149720354421468400UL},
+    {6607496772837067824UL, 1343575221513417750UL},
+    {17482743002901110588UL, 1679469026891772187UL},
+    {17241742735199000331UL, 2099336283614715234UL},
+    {15387775227926763111UL, 1312085177259197021UL},
+    {5399660979626290177UL, 1640106471573996277UL},
+    {11361262242960250625UL, 2050133089467495346UL},
+    {11712474920277544544UL, 1281333180917184591UL},
+    {10028907631919542777UL, 1601666476146480739UL},
+    {7924448521472040567UL, 2002083095183100924UL},
+    {14176152362774801162UL, 1251301934489438077UL},
+    {3885132398186337741UL, 1564127418111797597UL},
+    {9468101516160310080UL, 1955159272639746996UL},
+    {15140935484454969608UL, 1221974545399841872UL},
+    {479425281859160394UL, 1527468181749802341UL},
+    {5210967620751338397UL, 1909335227187252926UL},
+    {17091912818251750210UL, 1193334516992033078UL},
+    {12141518985959911954UL, 1491668146240041348UL},
+    {15176898732449889943UL, 1864585182800051685UL},
+    {11791404716994875166UL, 1165365739250032303UL},
+    {10127569877816206054UL, 1456707174062540379UL},
+    {8047776328842869663UL, 1820883967578175474UL},
+    {836348374198811271UL, 2276104959472719343UL},
+    {7440246761515338900UL, 1422565599670449589UL},
+    {13911994470321561530UL, 1778206999588061986UL},
+    {8166621051047176104UL, 2222758749485077483UL},
+    {2798295147690791113UL, 1389224218428173427UL},
+    {17332926989895652603UL, 1736530273035216783UL},
+    {17054472718942177850UL, 2170662841294020979UL},
+    {8353202440125167204UL, 1356664275808763112UL},
+    {10441503050156459005UL, 1695830344760953890UL},
+    {3828506775840797949UL, 2119787930951192363UL},
+    {86973725686804766UL, 1324867456844495227UL},
+    {13943775212390669669UL, 1656084321055619033UL},
+    {3594660960206173375UL, 2070105401319523792UL},
+    {2246663100128858359UL, 1293815875824702370UL},
+    {12031700912015848757UL, 1617269844780877962UL},
+    {5816254103165035138UL, 2021587305976097453UL},
+    {5941001823691840913UL, 1263492066235060908UL},
+    {7426252279614801142UL, 1579365082793826135UL},
+    {4671129331091113523UL, 1974206353492282669UL},
+    {5225298841145639904UL, 1233878970932676668UL},
+    {6531623551432049880UL, 1542348713665845835UL},
+    {3552843420862674446UL, 1927935892082307294UL},
+    {16055585193321335241UL, 1204959932551442058UL},
+    {10846109454796893243UL, 1506199915689302573UL},
+    {18169322836923504458UL, 1882749894611628216UL},
+    {11355826773077190286UL, 1176718684132267635UL},
+    {9583097447919099954UL, 1470898355165334544UL},
+    {11978871809898874942UL, 1838622943956668180UL},
+    {14973589762373593678UL, 2298278679945835225UL},
+    {2440964573842414192UL, 1436424174966147016UL},
+    {3051205717303017741UL, 1795530218707683770UL},
+    {13037379183483547984UL, 2244412773384604712UL},
+    {8148361989677217490UL, 1402757983365377945UL},
+    {14797138505523909766UL, 1753447479206722431UL},
+    {13884737113477499304UL, 2191809349008403039UL},
+    {15595489723564518921UL, 1369880843130251899UL},
+    {14882676136028260747UL, 1712351053912814874UL},
+    {9379973133180550126UL, 2140438817391018593UL},
+    {17391698254306313589UL, 1337774260869386620UL},
+    {3292878744173340370UL, 1672217826086733276UL},
+    {4116098430216675462UL, 2090272282608416595UL},
+    {266718509671728212UL, 1306420176630260372UL},
+    {333398137089660265UL, 1633025220787825465UL},
+    {5028433689789463235UL, 2041281525984781831UL},
+    {10060300083759496378UL, 1275800953740488644UL},
+    {12575375104699370472UL, 1594751192175610805UL},
+    {1884160825592049379UL, 1993438990219513507UL},
+    {17318501580490888525UL, 1245899368887195941UL},
+    {7813068920331446945UL, 1557374211108994927UL},
+    {5154650131986920777UL, 1946717763886243659UL},
+    {915813323278131534UL, 1216698602428902287UL},
+    {14979824709379828129UL, 1520873253036127858UL},
+    {9501408849870009354UL, 1901091566295159823UL},
+    {12855909558809837702UL, 1188182228934474889UL},
+    {2234828893230133415UL, 1485227786168093612UL},
+    {2793536116537666769UL, 1856534732710117015UL},
+    {8663489100477123587UL, 1160334207943823134UL},
+    {1605989338741628675UL, 1450417759929778918UL},
+    {11230858710281811652UL, 1813022199912223647UL},
+    {9426887369424876662UL, 2266277749890279559UL},
+    {12809333633531629769UL, 1416423593681424724UL},
+    {16011667041914537212UL, 1770529492101780905UL},
+    {6179525747111007803UL, 2213161865127226132UL},
+    {13085575628799155685UL, 1383226165704516332UL},
+    {16356969535998944606UL, 1729032707130645415UL},
+    {15834525901571292854UL, 2161290883913306769UL},
+    {2979049660840976177UL, 1350806802445816731UL},
+    {17558870131333383934UL, 1688508503057270913UL},
+    {8113529608884566205UL, 2110635628821588642UL},
+    {9682642023980241782UL, 1319147268013492901UL},
+    {16714988548402690132UL, 1648934085016866126UL},
+    {11670363648648586857UL, 2061167606271082658UL},
+    {11905663298832754689UL, 1288229753919426661UL},
+    {1047021068258779650UL, 1610287192399283327UL},
+    {15143834390605638274UL, 2012858990499104158UL},
+    {4853210475701136017UL, 1258036869061940099UL},
+    {1454827076199032118UL, 1572546086327425124UL},
+    {1818533845248790147UL, 1965682607909281405UL},
+    {3442426662494187794UL, 1228551629943300878UL},
+    {13526405364972510550UL, 1535689537429126097UL},
+    {3072948650933474476UL, 1919611921786407622UL},
+    {15755650962115585259UL, 1199757451116504763UL},
+    {15082877684217093670UL, 1499696813895630954UL},
+    {9630225068416591280UL, 1874621017369538693UL},
+    {8324733676974063502UL, 1171638135855961683UL},
+    {5794231077790191473UL, 1464547669819952104UL},
+    {7242788847237739342UL, 1830684587274940130UL},
+    {18276858095901949986UL, 2288355734093675162UL},
+    {16034722328366106645UL, 1430222333808546976UL},
+    {1596658836748081690UL, 1787777917260683721UL},
+    {6607509564362490017UL, 2234722396575854651UL},
+    {1823850468512862308UL, 1396701497859909157UL},
+    {6891499104068465790UL, 1745876872324886446UL},
+    {17837745916940358045UL, 2182346090406108057UL},
+    {4231062170446641922UL, 1363966306503817536UL},
+    {5288827713058302403UL, 1704957883129771920UL},
+    {6611034641322878003UL, 2131197353912214900UL},
+    {13355268687681574560UL, 1331998346195134312UL},
+    {16694085859601968200UL, 1664997932743917890UL},
+    {11644235287647684442UL, 2081247415929897363UL},
+    {4971804045566108824UL, 1300779634956185852UL},
+    {6214755056957636030UL, 1625974543695232315UL},
+    {3156757802769657134UL, 2032468179619040394UL},
+    {6584659645158423613UL, 1270292612261900246UL},
+    {17454196593302805324UL, 1587865765327375307UL},
+    {17206059723201118751UL, 1984832206659219134UL},
+    {6142101308573311315UL, 1240520129162011959UL},
+    {3065940617289251240UL, 1550650161452514949UL},
+    {8444111790038951954UL, 1938312701815643686UL},
+    {665883850346957067UL, 1211445438634777304UL},
+    {832354812933696334UL, 1514306798293471630UL},
+    {10263815553021896226UL, 1892883497866839537UL},
+    {17944099766707154901UL, 1183052186166774710UL},
+    {13206752671529167818UL, 1478815232708468388UL},
+    {16508440839411459773UL, 1848519040885585485UL},
+    {12623618533845856310UL, 1155324400553490928UL},
+    {15779523167307320387UL, 1444155500691863660UL},
+    {1277659885424598868UL, 1805194375864829576UL},
+    {1597074856780748586UL, 2256492969831036970UL},
+    {5609857803915355770UL, 1410308106144398106UL},
+    {16235694291748970521UL, 1762885132680497632UL},
+    {1847873790976661535UL, 2203606415850622041UL},
+    {12684136165428883219UL, 1377254009906638775UL},
+    {11243484188358716120UL, 1721567512383298469UL},
+    {219297180166231438UL, 2151959390479123087UL},
+    {7054589765244976505UL, 1344974619049451929UL},
+    {13429923224983608535UL, 1681218273811814911UL},
+    {12175718012802122765UL, 2101522842264768639UL},
+    {14527352785642408584UL, 1313451776415480399UL},
+    {13547504963625622826UL, 1641814720519350499UL},
+    {12322695186104640628UL, 2052268400649188124UL},
+    {16925056528170176201UL, 1282667750405742577UL},
+    {7321262604930556539UL, 1603334688007178222UL},
+    {18374950293017971482UL, 2004168360008972777UL},
+    {4566814905495150320UL, 1252605225005607986UL},
+    {14931890668723713708UL, 1565756531257009982UL},
+    {9441491299049866327UL, 1957195664071262478UL},
+    {1289246043478778550UL, 1223247290044539049UL},
+    {6223243572775861092UL, 1529059112555673811UL},
+    {3167368447542438461UL, 1911323890694592264UL},
+    {1979605279714024038UL, 1194577431684120165UL},
+    {7086192618069917952UL, 1493221789605150206UL},
+    {18081112809442173248UL, 1866527237006437757UL},
+    {13606538515115052232UL, 1166579523129023598UL},
+    {7784801107039039482UL, 1458224403911279498UL},
+    {507629346944023544UL, 1822780504889099373UL},
+    {5246222702107417334UL, 2278475631111374216UL},
+    {3278889188817135834UL, 1424047269444608885UL},
+    {8710297504448807696UL, 1780059086805761106UL}
+};
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 uint128;
+
+// (m * mul) >> j, где mul — 128-битное число из таблицы, j >= 64
+static unsigned long mul_shift(unsigned long m, const unsigned long* mul,
+                               int j) {
+  uint128 low = (uint128)m * mul[0];
+  uint128 high = (uint128)m * mul[1];
+  return (unsigned long)(((low >> 64) + high) >> (j - 64));
+}
+#else
+// 64 x 64 -> 128 бит: младшая половина результата, старшая — в *high
+static unsigned long mul_128(unsigned long a, unsigned long b,
+                             unsigned long* high) {
+  unsigned long a_low = a & 0xFFFFFFFFUL;
+  unsigned long a_high = a >> 32;
+  unsigned long b_low = b & 0xFFFFFFFFUL;
+  unsigned long b_high = b >> 32;
+  unsigned long low_low = a_low * b_low;
+  unsigned long middle1 = a_high * b_low + (low_low >> 32);
+  unsigned long middle2 = a_low * b_high + (middle1 & 0xFFFFFFFFUL);
+  *high = a_high * b_high + (middle1 >> 32) + (middle2 >> 32);
+  return (middle2 << 32) | (low_low & 0xFFFFFFFFUL);
+}
+
+static unsigned long mul_shift(unsigned long m, const unsigned long* mul,
+                               int j) {
+  unsigned long high0 = 0;
+  unsigned long high1 = 0;
+  mul_128(m, mul[0], &high0);
+  unsigned long sum = mul_128(m, mul[1], &high1) + high0;
+  if (sum < high0) {
+    high1++;
+  }
+  int shift = j - 64;  // от 1 до 63
+  return (high1 << (64 - shift)) | (sum >> shift);
+}
+#endif
+
+// число бит в 5^e (для e = 0 — единица), 0 <= e <= 3528
+static int pow5_bits(int e) {
+  return (int)(((unsigned)e * 1217359U) >> 19) + 1;
+}
+
+// floor(log10(2^e)) для 0 <= e <= 1650
+static int log10_pow2(int e) { return (int)(((unsigned)e * 78913U) >> 18); }
+
+// floor(log10(5^e)) для 0 <= e <= 2620
+static int log10_pow5(int e) { return (int)(((unsigned)e * 732923U) >> 20); }
+
+static bool multiple_of_pow5(unsigned long value, int p) {
+  int count = 0;
+  while (value % 5 == 0 && count < p) {
+    value /= 5;
+    count++;
+  }
+  return count >= p;
+}
+
+static bool multiple_of_pow2(unsigned long value, int p) {
+  return (value & ((1UL << p) - 1)) == 0;
+}
+
+/* Кратчайшие цифры положительного double с полями ieee_mant и ieee_exp:
+результат — целое, значение = результат * 10^(*exp10). */
+static unsigned long shortest_digits(unsigned long ieee_mant, int ieee_exp,
+                                     int* exp10) {
+  unsigned long m2 = ieee_mant;
+  int e2 = 1 - 1075 - 2;
+  if (ieee_exp != 0) {
+    m2 |= 1UL << 52;
+    e2 = ieee_exp - 1075 - 2;
+  }
+  // при чётной мантиссе границы интервала тоже читаются как это число
+  const bool accept_bounds = (m2 & 1) == 0;
+
+  // середины до соседних чисел: mv - 2 (или - 1 на границе степени двойки)
+  // и mv + 2, всё умножено на 4
+  const unsigned long mv = 4 * m2;
+  const unsigned mm_shift = ieee_mant != 0 || ieee_exp <= 1;
+
+  unsigned long vr = 0;
+  unsigned long vp = 0;
+  unsigned long vm = 0;
+  int e10 = 0;
+  bool vm_trailing_zeros = false;
+  bool vr_trailing_zeros = false;
+
+  if (e2 >= 0) {
+    const int q = log10_pow2(e2) - (e2 > 3);
+    const int k = POW5_INV_BITCOUNT + pow5_bits(q) - 1;
+    const int i = -e2 + q + k;
+    e10 = q;
+    vr = mul_shift(4 * m2, pow5_inv_split[q], i);
+    vp = mul_shift(4 * m2 + 2, pow5_inv_split[q], i);
+    vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_inv_split[q], i);
+    if (q <= 21) {
+      // только здесь отброшенные цифры могут оказаться нулями
+      if (mv % 5 == 0) {
+        vr_trailing_zeros = multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= multiple_of_pow5(mv + 2, q);
+      }
+    }
+  } else {
+    const int q = log10_pow5(-e2) - (-e2 > 1);
+    const int i = -e2 - q;
+    const int k = pow5_bits(i) - POW5_BITCOUNT;
+    const int j = q - k;
+    e10 = q + e2;
+    vr = mul_shift(4 * m2, pow5_split[i], j);
+    vp = mul_shift(4 * m2 + 2, pow5_split[i], j);
+    vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_split[i], j);
+    if (q <= 1) {
+      // у mv не меньше q нулевых младших битов, так что vr точен
+      vr_trailing_zeros = true;
+      if (accept_bounds) {
+        vm_trailing_zeros = mm_shift == 1;
+      } else {
+        vp--;
+      }
+    } else if (q < 63) {
+      vr_trailing_zeros = multiple_of_pow2(mv, q);
+    }
+  }
+
+  // отбрасываем цифры, пока интервал (vm, vp) вмещает более короткое число
+  int removed = 0;
+  int last_removed = 0;
+  unsigned long output = 0;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    // редкий случай: нужно помнить, были ли отброшенные цифры нулями
+    while (vp / 10 > vm / 10) {
+      vm_trailing_zeros &= vm % 10 == 0;
+      vr_trailing_zeros &= last_removed == 0;
+      last_removed = (int)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    if (vm_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_trailing_zeros &= last_removed == 0;
+        last_removed = (int)(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        removed++;
+      }
+    }
+    if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+      // ровно половина: к чётному
+      last_removed = 4;
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+                   last_removed >= 5);
+  } else {
+    bool round_up = false;
+    if (vp / 100 > vm / 100) {
+      round_up = vr % 100 >= 50;
+      vr /= 100;
+      vp /= 100;
+      vm /= 100;
+      removed += 2;
+    }
+    while (vp / 10 > vm / 10) {
+      round_up = vr % 10 >= 5;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+
+  *exp10 = e10 + removed;
+  return output;
+}
+
+/* Кратчайшие цифры |value|, которые читаются обратно в тот же double; в
+dec->digits должно быть место для S21_SHORTEST_DIGITS цифр. */
+void s21_decimal_shortest(s21_decimal* dec, double value) {
+  union {
+    double d;
+    unsigned long bits;
+  } pun = {value};
+  unsigned long ieee_mant = pun.bits & ((1UL << 52) - 1);
+  int ieee_exp = (int)((pun.bits >> 52) & 0x7FF);
+
+  dec->count = 0;
+  dec->point = 1;
+  dec->sticky = false;
+  if (ieee_mant || ieee_exp) {
+    int exp10 = 0;
+    unsigned long digits = shortest_digits(ieee_mant, ieee_exp, &exp10);
+    for (; digits % 10 == 0; digits /= 10) {
+      exp10++;
+    }
+    int n = 0;
+    for (unsigned long rest = digits; rest; rest /= 10) {
+      n++;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+      dec->digits[i] = (char)('0' + digits % 10);
+      digits /= 10;
+    }
+    dec->count = n;
+    dec->point = exp10 + n;
+  }
+}
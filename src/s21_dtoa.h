@@ -0,0 +1,31 @@
+#ifndef S21_DTOA_H
+#define S21_DTOA_H
+
+#include <stdbool.h>
+
+#include "s21_string.h"
+
+/* Внутренний заголовок: перевод двоичных чисел с плавающей точкой в
+десятичные цифры для s21_sprintf. Число задаётся как mant * 2^exp2; цифры
+получаются точно (без промежуточной арифметики с плавающей точкой), так что
+округление до любой точности правильное. */
+
+typedef struct s21_decimal {
+  char* digits;  // значащие цифры '0'..'9', первая — ненулевая
+  int count;     // записано цифр; все следующие — нули
+  int point;     // значение = 0.d1d2d3... * 10^point
+  bool sticky;   // за digits[count - 1] есть ненулевые цифры
+} s21_decimal;
+
+// цифр в кратчайшем представлении double не больше 17
+#define S21_SHORTEST_DIGITS 17
+
+int s21_float_split(long double value, bool long_double, unsigned long* mant);
+int s21_decimal_point_bound(unsigned long mant, int exp2);
+int s21_decimal_digits_bound(unsigned long mant, int exp2);
+void s21_decimal_exact(s21_decimal* dec, unsigned long mant, int exp2,
+                       int want);
+void s21_decimal_round(s21_decimal* dec, long keep);
+void s21_decimal_shortest(s21_decimal* dec, double value);
+
+#endif
@@ -0,0 +1,381 @@
+#include "s21_string.h"
+
+/* Многошаблонный поиск Ахо-Корасик. Автомат строится по бору шаблонов;
+переходы хранятся двумя способами:
+- корень и состояния глубины 1 — плотные строки по 256 переходов, в которых
+  уже учтены ссылки неудачи (через них проходит почти каждый байт текста);
+- более глубокие состояния — отсортированные по байту списки рёбер, лежащие
+  подряд в общем массиве, плюс ссылка неудачи.
+Для каждого состояния хранятся свои шаблоны и ссылка на ближайшее по цепочке
+неудач состояние, в котором тоже заканчивается шаблон. */
+
+#define DENSE_DEPTH 2
+
+typedef struct ac_state {
+  int fail;
+  int output_link;    // состояние со следующими совпадениями или -1
+  int dense_row;      // строка в dense или -1
+  unsigned edges;     // первое ребро в edge_bytes/edge_targets
+  unsigned edge_count;
+  unsigned outputs;   // первый шаблон в output_patterns
+  unsigned output_count;
+} ac_state;
+
+struct s21_multisearch {
+  const s21_allocator* allocator;
+  ac_state* states;
+  int state_count;
+  int* dense;
+  unsigned char* edge_bytes;
+  int* edge_targets;
+  s21_size_t* output_patterns;
+  s21_size_t* pattern_lens;
+};
+
+// узел бора на время построения: дети и шаблоны — односвязные списки
+typedef struct ac_node {
+  int parent;
+  int first_child;
+  int next_sibling;
+  int first_pattern;
+  int depth;
+  unsigned char byte;
+} ac_node;
+
+typedef struct ac_builder {
+  const s21_allocator* allocator;
+  ac_node* nodes;
+  int count;
+  int capacity;
+  int* pattern_next;  // следующий шаблон с тем же концом
+} ac_builder;
+
+static int node_child(const ac_builder* b, int node, unsigned char byte) {
+  int child = b->nodes[node].first_child;
+  while (child >= 0 && b->nodes[child].byte != byte) {
+    child = b->nodes[child].next_sibling;
+  }
+  return child;
+}
+
+static int add_node(ac_builder* b, int parent, unsigned char byte) {
+  int node = -1;
+
+  if (b->count == b->capacity) {
+    int capacity = b->capacity * 2;
+    ac_node* nodes = s21_allocate(b->allocator, capacity * sizeof(ac_node));
+    if (nodes) {
+      s21_memcpy(nodes, b->nodes, b->count * sizeof(ac_node));
+      s21_deallocate(b->allocator, b->nodes);
+      b->nodes = nodes;
+      b->capacity = capacity;
+    }
+  }
+  if (b->count < b->capacity) {
+    node = b->count++;
+    b->nodes[node].parent = parent;
+    b->nodes[node].first_child = -1;
+    b->nodes[node].first_pattern = -1;
+    b->nodes[node].byte = byte;
+    b->nodes[node].depth = parent >= 0 ? b->nodes[parent].depth + 1 : 0;
+    if (parent >= 0) {
+      b->nodes[node].next_sibling = b->nodes[parent].first_child;
+      b->nodes[parent].first_child = node;
+    } else {
+      b->nodes[node].next_sibling = -1;
+    }
+  }
+
+  return node;
+}
+
+static int build_trie(ac_builder* b, const char* const* patterns,
+                      s21_size_t count, s21_size_t* lens) {
+  int status = 0;
+
+  for (s21_size_t i = 0; status == 0 && i < count; i++) {
+    const unsigned char* p = (const unsigned char*)patterns[i];
+    if (p == S21_NULL) {
+      status = -1;
+    } else {
+      lens[i] = s21_strlen(patterns[i]);
+      int node = 0;
+      for (s21_size_t j = 0; node >= 0 && j < lens[i]; j++) {
+        int child = node_child(b, node, p[j]);
+        node = child >= 0 ? child : add_node(b, node, p[j]);
+      }
+      if (node < 0) {
+        status = -1;
+      } else if (node > 0) {
+        // пустые шаблоны ничему не соответствуют
+        b->pattern_next[i] = b->nodes[node].first_pattern;
+        b->nodes[node].first_pattern = (int)i;
+      }
+    }
+  }
+
+  return status;
+}
+
+static int multisearch_alloc(s21_multisearch* ms, const ac_builder* b,
+                             int dense_rows, s21_size_t outputs) {
+  int n = b->count;
+  ms->state_count = n;
+  const s21_allocator* allocator = ms->allocator;
+  ms->states = s21_allocate(allocator, n * sizeof(ac_state));
+  ms->dense =
+      s21_allocate(allocator, (s21_size_t)dense_rows * 256 * sizeof(int));
+  ms->edge_bytes = s21_allocate(allocator, n);
+  ms->edge_targets = s21_allocate(allocator, n * sizeof(int));
+  ms->output_patterns =
+      s21_allocate(allocator, (outputs + 1) * sizeof(s21_size_t));
+
+  int status = 0;
+  if (!ms->states || !ms->dense || !ms->edge_bytes || !ms->edge_targets ||
+      !ms->output_patterns) {
+    status = -1;
+  }
+
+  return status;
+}
+
+// рёбра узла в порядке возрастания байта (вставками: детей немного)
+static void compile_edges(s21_multisearch* ms, const ac_builder* b, int node,
+                          unsigned* next_edge) {
+  ac_state* st = &ms->states[node];
+  st->edges = *next_edge;
+  st->edge_count = 0;
+  for (int c = b->nodes[node].first_child; c >= 0;
+       c = b->nodes[c].next_sibling) {
+    unsigned i = st->edges + st->edge_count++;
+    while (i > st->edges && ms->edge_bytes[i - 1] > b->nodes[c].byte) {
+      ms->edge_bytes[i] = ms->edge_bytes[i - 1];
+      ms->edge_targets[i] = ms->edge_targets[i - 1];
+      i--;
+    }
+    ms->edge_bytes[i] = b->nodes[c].byte;
+    ms->edge_targets[i] = c;
+  }
+  *next_edge += st->edge_count;
+}
+
+static int sparse_next(const s21_multisearch* ms, const ac_state* st,
+                       unsigned char byte) {
+  const unsigned char* bytes = ms->edge_bytes + st->edges;
+  unsigned lo = 0, hi = st->edge_count;
+  int next = -1;
+
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (bytes[mid] < byte) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < st->edge_count && bytes[lo] == byte) {
+    next = ms->edge_targets[st->edges + lo];
+  }
+
+  return next;
+}
+
+static int state_next(const s21_multisearch* ms, int state,
+                      unsigned char byte) {
+  int next = -1;
+
+  // цепочка неудач всегда приводит к состоянию с плотной строкой
+  while (next < 0 && ms->states[state].dense_row < 0) {
+    next = sparse_next(ms, &ms->states[state], byte);
+    if (next < 0) {
+      state = ms->states[state].fail;
+    }
+  }
+  if (next < 0) {
+    next = ms->dense[ms->states[state].dense_row * 256 + byte];
+  }
+
+  return next;
+}
+
+// ссылка неудачи, ссылка на совпадения и плотная строка узла
+static void link_state(s21_multisearch* ms, const ac_builder* b, int node,
+                       int* next_row) {
+  ac_state* st = &ms->states[node];
+  const ac_node* n = &b->nodes[node];
+
+  if (node == 0 || n->parent == 0) {
+    st->fail = 0;
+  } else {
+    st->fail = state_next(ms, ms->states[n->parent].fail, n->byte);
+  }
+
+  const ac_state* fail = &ms->states[st->fail];
+  if (node == 0) {
+    st->output_link = -1;
+  } else {
+    st->output_link = fail->output_count > 0 ? st->fail : fail->output_link;
+  }
+
+  st->dense_row = -1;
+  if (n->depth < DENSE_DEPTH) {
+    int* row = ms->dense + *next_row * 256;
+    st->dense_row = (*next_row)++;
+    for (int c = 0; c < 256; c++) {
+      row[c] = node == 0 ? 0 : ms->dense[c];
+    }
+    for (unsigned e = 0; e < st->edge_count; e++) {
+      row[ms->edge_bytes[st->edges + e]] = ms->edge_targets[st->edges + e];
+    }
+  }
+}
+
+/* Состояния обрабатываются в порядке обхода бора в ширину: к моменту
+обработки узла все более мелкие состояния (в том числе вся его цепочка
+неудач) уже готовы. */
+static int compile(s21_multisearch* ms, const ac_builder* b) {
+  int status = 0;
+  int* queue = s21_allocate(b->allocator, b->count * sizeof(int));
+  int dense_rows = 0;
+  s21_size_t outputs = 0;
+
+  for (int i = 0; i < b->count; i++) {
+    dense_rows += b->nodes[i].depth < DENSE_DEPTH;
+    for (int p = b->nodes[i].first_pattern; p >= 0; p = b->pattern_next[p]) {
+      outputs++;
+    }
+  }
+
+  if (queue == S21_NULL || multisearch_alloc(ms, b, dense_rows, outputs)) {
+    status = -1;
+  } else {
+    int head = 0, tail = 0, row = 0;
+    unsigned next_edge = 0, next_output = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+      int node = queue[head++];
+      ac_state* st = &ms->states[node];
+
+      compile_edges(ms, b, node, &next_edge);
+      for (unsigned e = 0; e < st->edge_count; e++) {
+        queue[tail++] = ms->edge_targets[st->edges + e];
+      }
+
+      st->outputs = next_output;
+      st->output_count = 0;
+      for (int p = b->nodes[node].first_pattern; p >= 0;
+           p = b->pattern_next[p]) {
+        ms->output_patterns[next_output++] = (s21_size_t)p;
+        st->output_count++;
+      }
+
+      link_state(ms, b, node, &row);
+    }
+  }
+  s21_deallocate(b->allocator, queue);
+
+  return status;
+}
+
+/* Автомат и временные массивы построения берутся у распределителя потока;
+s21_multisearch_free возвращает память тому же распределителю. */
+s21_multisearch* s21_multisearch_build(const char* const* patterns,
+                                       s21_size_t count) {
+  const s21_allocator* allocator = s21_thread_allocator();
+  s21_multisearch* ms = s21_allocate(allocator, sizeof(s21_multisearch));
+  ac_builder b = {allocator, S21_NULL, 0, 16, S21_NULL};
+  int status = -1;
+
+  if (ms) {
+    *ms = (s21_multisearch){.allocator = allocator};
+  }
+  if (ms && (patterns || count == 0)) {
+    b.nodes = s21_allocate(allocator, b.capacity * sizeof(ac_node));
+    b.pattern_next = s21_allocate(allocator, (count + 1) * sizeof(int));
+    ms->pattern_lens =
+        s21_allocate(allocator, (count + 1) * sizeof(s21_size_t));
+    if (b.nodes && b.pattern_next && ms->pattern_lens &&
+        add_node(&b, -1, 0) == 0 &&
+        build_trie(&b, patterns, count, ms->pattern_lens) == 0) {
+      status = compile(ms, &b);
+    }
+  }
+  s21_deallocate(allocator, b.nodes);
+  s21_deallocate(allocator, b.pattern_next);
+
+  if (status != 0) {
+    s21_multisearch_free(ms);
+    ms = S21_NULL;
+  }
+
+  return ms;
+}
+
+void s21_multisearch_free(s21_multisearch* ms) {
+  if (ms) {
+    const s21_allocator* allocator = ms->allocator;
+    s21_deallocate(allocator, ms->states);
+    s21_deallocate(allocator, ms->dense);
+    s21_deallocate(allocator, ms->edge_bytes);
+    s21_deallocate(allocator, ms->edge_targets);
+    s21_deallocate(allocator, ms->output_patterns);
+    s21_deallocate(allocator, ms->pattern_lens);
+    s21_deallocate(allocator, ms);
+  }
+}
+
+/* Один проход по тексту; о каждом совпадении сообщается в порядке позиции
+его конца (при общем конце — сначала более длинные шаблоны). Ненулевой
+результат callback останавливает поиск. Возвращает число совпадений, о
+которых было сообщено. */
+s21_size_t s21_multisearch_scan(const s21_multisearch* ms, const char* text,
+                                s21_match_callback callback, void* context) {
+  const unsigned char* t = (const unsigned char*)text;
+  s21_size_t len = s21_strlen(text);
+  s21_size_t reported = 0;
+  int stop = 0;
+  int state = 0;
+
+  for (s21_size_t i = 0; !stop && i < len; i++) {
+    state = state_next(ms, state, t[i]);
+    int out = ms->states[state].output_count > 0
+                  ? state
+                  : ms->states[state].output_link;
+    for (; !stop && out >= 0; out = ms->states[out].output_link) {
+      const ac_state* st = &ms->states[out];
+      for (unsigned k = 0; !stop && k < st->output_count; k++) {
+        s21_match match;
+        match.pattern = ms->output_patterns[st->outputs + k];
+        match.offset = i + 1 - ms->pattern_lens[match.pattern];
+        reported++;
+        stop = callback(&match, context);
+      }
+    }
+  }
+
+  return reported;
+}
+
+typedef struct match_array {
+  s21_match* matches;
+  s21_size_t capacity;
+  s21_size_t count;
+} match_array;
+
+static int collect_match(const s21_match* match, void* context) {
+  match_array* array = (match_array*)context;
+  if (array->count < array->capacity) {
+    array->matches[array->count] = *match;
+  }
+  array->count++;
+  return 0;
+}
+
+/* Записывает не больше capacity первых совпадений в matches и возвращает
+общее их число (может быть больше capacity). */
+s21_size_t s21_multisearch_find(const s21_multisearch* ms, const char* text,
+                                s21_match* matches, s21_size_t capacity) {
+  match_array array = {matches, capacity, 0};
+  s21_multisearch_scan(ms, text, collect_match, &array);
+  return array.count;
+}
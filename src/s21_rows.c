@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "s21_rows.h"
+#include "s21_string.h"
+
+/* Многопоточное форматирование таблицы. Строки делятся на куски, и потоки
+берут куски по одному из общего счётчика: освободившийся поток сразу
+забирает следующий, так что строки разной длины распределяются сами.
+Каждый кусок форматируется в свой буфер; префиксные суммы длин кусков дают
+их места в общем выводе, и куски так же параллельно копируются туда.
+Результат совпадает с s21_format_rows байт в байт. */
+
+#define ROWS_MAX_THREADS 256
+// кусков на поток: достаточно, чтобы было что перераспределять
+#define ROWS_CHUNKS_PER_THREAD 8
+#define ROWS_MIN_CHUNK 256
+#define ROWS_MAX_CHUNK 65536
+// первая оценка длины строки, дальше — по прошлому куску потока
+#define ROWS_FIRST_GUESS 16
+
+typedef struct rows_chunk {
+  char* data;  // вывод куска
+  s21_size_t len;
+  s21_size_t base;  // смещение куска в общем выводе
+} rows_chunk;
+
+typedef struct rows_job {
+  char* str;
+  s21_size_t size;
+  const s21_format* format;
+  const s21_column* columns;
+  s21_size_t rows;
+  s21_size_t* offsets;
+  s21_size_t chunk_rows;
+  s21_size_t chunk_count;
+  rows_chunk* chunks;
+  atomic_size_t next;  // первый ещё не взятый кусок
+  atomic_int err;
+} rows_job;
+
+static void chunk_range(const rows_job* job, s21_size_t i, s21_size_t* first,
+                        s21_size_t* last) {
+  *first = i * job->chunk_rows;
+  *last = job->rows - *first < job->chunk_rows ? job->rows
+                                               : *first + job->chunk_rows;
+}
+
+/* Форматирует кусок i в буфер по оценке guess (байтов на строку); если
+оценка мала, буфер расширяется до точного размера и кусок форматируется
+ещё раз. */
+static int format_chunk(rows_job* job, s21_size_t i, s21_size_t* guess) {
+  rows_chunk* chunk = &job->chunks[i];
+  s21_size_t first = 0, last = 0;
+  chunk_range(job, i, &first, &last);
+  s21_size_t cap = *guess * (last - first) + 1;
+  int status = -1;
+
+  chunk->data = malloc(cap);
+  if (chunk->data) {
+    status = s21_format_row_range(chunk->data, cap, job->format, job->columns,
+                                  first, last, job->offsets, &chunk->len);
+  }
+  if (status == 0 && chunk->len >= cap) {
+    char* data = realloc(chunk->data, chunk->len + 1);
+    status = -1;
+    if (data) {
+      chunk->data = data;
+      status = s21_format_row_range(data, chunk->len + 1, job->format,
+                                    job->columns, first, last, job->offsets,
+                                    &chunk->len);
+    }
+  }
+  if (status == 0) {
+    *guess = chunk->len / (last - first) + 1;
+  }
+
+  return status;
+}
+
+// переносит кусок i на его место в общем выводе
+static void copy_chunk(rows_job* job, s21_size_t i) {
+  rows_chunk* chunk = &job->chunks[i];
+  s21_size_t first = 0, last = 0;
+  chunk_range(job, i, &first, &last);
+
+  for (s21_size_t row = first; row < last; row++) {
+    job->offsets[row] += chunk->base;
+  }
+  if (chunk->base < job->size) {
+    s21_size_t room = job->size - 1 - chunk->base;
+    s21_memcpy(job->str + chunk->base, chunk->data,
+               chunk->len < room ? chunk->len : room);
+  }
+  free(chunk->data);
+  chunk->data = S21_NULL;
+}
+
+static void* format_worker(void* arg) {
+  rows_job* job = arg;
+  s21_size_t guess = ROWS_FIRST_GUESS;
+  s21_size_t i = 0;
+  while ((i = atomic_fetch_add(&job->next, 1)) < job->chunk_count) {
+    if (atomic_load(&job->err) == 0 && format_chunk(job, i, &guess) != 0) {
+      atomic_store(&job->err, -1);
+    }
+  }
+  return S21_NULL;
+}
+
+static void* copy_worker(void* arg) {
+  rows_job* job = arg;
+  s21_size_t i = 0;
+  while ((i = atomic_fetch_add(&job->next, 1)) < job->chunk_count) {
+    copy_chunk(job, i);
+  }
+  return S21_NULL;
+}
+
+/* Выполняет worker в threads потоках, считая текущий. Если поток не
+создался, работу доделают остальные: куски берутся из общего счётчика. */
+static void run_workers(rows_job* job, int threads, void* (*worker)(void*)) {
+  pthread_t ids[ROWS_MAX_THREADS];
+  int started = 0;
+
+  atomic_store(&job->next, 0);
+  while (started < threads - 1 &&
+         pthread_create(&ids[started], S21_NULL, worker, job) == 0) {
+    started++;
+  }
+  worker(job);
+  for (int i = 0; i < started; i++) {
+    pthread_join(ids[i], S21_NULL);
+  }
+}
+
+/* s21_format_rows в threads потоках (threads <= 0 — по числу процессоров).
+Вывод и смещения те же; возвращает 0 или -1, как s21_format_rows, а также
+если не хватило памяти. */
+int s21_format_rows_parallel(char* str, s21_size_t size,
+                             const s21_format* format,
+                             const s21_column* columns, s21_size_t rows,
+                             s21_size_t* offsets, int threads) {
+  int status = 0;
+
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 && cpus < ROWS_MAX_THREADS ? (int)cpus : 1;
+    if (cpus >= ROWS_MAX_THREADS) {
+      threads = ROWS_MAX_THREADS;
+    }
+  } else if (threads > ROWS_MAX_THREADS) {
+    threads = ROWS_MAX_THREADS;
+  }
+  s21_size_t chunk_rows = rows / ((s21_size_t)threads * ROWS_CHUNKS_PER_THREAD);
+  if (chunk_rows < ROWS_MIN_CHUNK) {
+    chunk_rows = ROWS_MIN_CHUNK;
+  } else if (chunk_rows > ROWS_MAX_CHUNK) {
+    chunk_rows = ROWS_MAX_CHUNK;
+  }
+
+  if (threads == 1 || rows <= chunk_rows) {
+    status = s21_format_rows(str, size, format, columns, rows, offsets);
+  } else {
+    rows_job job = {.str = str,
+                    .size = size,
+                    .format = format,
+                    .columns = columns,
+                    .rows = rows,
+                    .offsets = offsets,
+                    .chunk_rows = chunk_rows,
+                    .chunk_count = (rows + chunk_rows - 1) / chunk_rows};
+    atomic_init(&job.next, 0);
+    atomic_init(&job.err, 0);
+    if ((s21_size_t)threads > job.chunk_count) {
+      threads = (int)job.chunk_count;
+    }
+
+    job.chunks = calloc(job.chunk_count, sizeof(rows_chunk));
+    if (job.chunks == S21_NULL) {
+      status = -1;
+    } else {
+      run_workers(&job, threads, format_worker);
+      status = atomic_load(&job.err);
+
+      s21_size_t total = 0;
+      for (s21_size_t i = 0; i < job.chunk_count; i++) {
+        job.chunks[i].base = total;
+        total += job.chunks[i].len;
+      }
+      if (status == 0) {
+        run_workers(&job, threads, copy_worker);
+      } else {
+        for (s21_size_t i = 0; i < job.chunk_count; i++) {
+          free(job.chunks[i].data);
+        }
+      }
+      offsets[rows] = total;
+      if (size > 0) {
+        str[total < size ? total : size - 1] = '\0';
+      }
+      free(job.chunks);
+    }
+  }
+
+  return status;
+}
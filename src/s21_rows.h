@@ -0,0 +1,14 @@
+#ifndef S21_ROWS_H
+#define S21_ROWS_H
+
+#include "s21_string.h"
+
+/* Внутренний заголовок: форматирование части строк таблицы для
+s21_format_rows и её многопоточного варианта. */
+
+int s21_format_row_range(char* str, s21_size_t size, const s21_format* format,
+                         const s21_column* columns, s21_size_t first,
+                         s21_size_t last, s21_size_t* offsets,
+                         s21_size_t* len);
+
+#endif
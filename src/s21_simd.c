@@ -0,0 +1,975 @@
+#include "s21_simd.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define S21_X86_64
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifdef S21_X86_64
+
+/* SSE2 входит в базовый набор x86-64, поэтому эти версии доступны всегда;
+AVX2-версии (по 32 байта за шаг) включаются, только если их поддерживает
+процессор и ОС. */
+#define AVX2 __attribute__((target("avx2")))
+
+// скалярные типы для невыровненного доступа к памяти
+typedef unsigned long long __attribute__((aligned(1), may_alias)) u64;
+typedef unsigned int __attribute__((aligned(1), may_alias)) u32;
+typedef unsigned short __attribute__((aligned(1), may_alias)) u16;
+
+#define LOAD(t, p) (*(const t*)(p))
+#define STORE(t, p, x) (*(t*)(p) = (x))
+
+/* Начиная с этого размера mem*-функции пишут потоковыми командами. По
+умолчанию — 3/4 самого большого кэша процессора (обычно общего L3). */
+static s21_size_t nt_threshold = 4 * 1024 * 1024;
+
+// маска байтов блока по адресу p, равных соответствующим байтам v
+#define SSE2_MATCH(p, v)        \
+  ((unsigned)_mm_movemask_epi8( \
+      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p)), (v))))
+#define AVX2_MATCH(p, v)           \
+  ((unsigned)_mm256_movemask_epi8( \
+      _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p)), (v))))
+
+// маска отличающихся байтов двух блоков
+#define SSE2_DIFF(p1, p2) \
+  (SSE2_MATCH(p1, _mm_loadu_si128((const __m128i*)(p2))) ^ 0xFFFFu)
+#define AVX2_DIFF(p1, p2) \
+  (~AVX2_MATCH(p1, _mm256_loadu_si256((const __m256i*)(p2))))
+
+static void* sse2_memchr(const void* str, int c, s21_size_t n) {
+  const unsigned char* s = (const unsigned char*)str;
+  void* result = S21_NULL;
+
+  if (n < 16) {
+    result = s21_memchr_scalar(str, c, n);
+  } else {
+    const __m128i needle = _mm_set1_epi8((char)c);
+    const unsigned char* last = s + n - 16;
+    unsigned mask = 0;
+    while (s < last && !(mask = SSE2_MATCH(s, needle))) {
+      s += 16;
+    }
+    // последний блок перекрывает предыдущий, чтобы не выходить за n
+    if (!mask) {
+      s = last;
+      mask = SSE2_MATCH(s, needle);
+    }
+    if (mask) {
+      result = (void*)(s + __builtin_ctz(mask));
+    }
+  }
+
+  return result;
+}
+
+static int sse2_memcmp(const void* str1, const void* str2, s21_size_t n) {
+  const unsigned char* s1 = (const unsigned char*)str1;
+  const unsigned char* s2 = (const unsigned char*)str2;
+  int result = 0;
+
+  if (n < 16) {
+    result = s21_memcmp_scalar(str1, str2, n);
+  } else {
+    s21_size_t i = 0;
+    unsigned diff = 0;
+    while (i < n - 16 && !(diff = SSE2_DIFF(s1 + i, s2 + i))) {
+      i += 16;
+    }
+    if (!diff) {
+      i = n - 16;
+      diff = SSE2_DIFF(s1 + i, s2 + i);
+    }
+    if (diff) {
+      i += __builtin_ctz(diff);
+      result = s1[i] - s2[i];
+    }
+  }
+
+  return result;
+}
+
+/* Копирование по размерам:
+- до 16 байт — два перекрывающихся невыровненных слова;
+- до 32 байт — два перекрывающихся 16-байтных блока;
+- больше — выравнивание приёмника и цикл выровненных записей, а начиная с
+  nt_threshold — потоковые (non-temporal) записи мимо кэша, чтобы большое
+  копирование не вытесняло рабочий набор.
+Во всех ветках первый и последний блоки читаются до любой записи, поэтому
+копирование вперёд корректно и при перекрытии, если dest < src. */
+static void copy_small(unsigned char* d, const unsigned char* s,
+                       s21_size_t n) {
+  if (n >= 8) {
+    u64 head = LOAD(u64, s), tail = LOAD(u64, s + n - 8);
+    STORE(u64, d, head);
+    STORE(u64, d + n - 8, tail);
+  } else if (n >= 4) {
+    u32 head = LOAD(u32, s), tail = LOAD(u32, s + n - 4);
+    STORE(u32, d, head);
+    STORE(u32, d + n - 4, tail);
+  } else if (n >= 2) {
+    u16 head = LOAD(u16, s), tail = LOAD(u16, s + n - 2);
+    STORE(u16, d, head);
+    STORE(u16, d + n - 2, tail);
+  } else if (n == 1) {
+    *d = *s;
+  }
+}
+
+static void sse2_copy_forward(unsigned char* d, const unsigned char* s,
+                              s21_size_t n) {
+  if (n <= 16) {
+    copy_small(d, s, n);
+  } else {
+    __m128i head = _mm_loadu_si128((const __m128i*)s);
+    __m128i tail = _mm_loadu_si128((const __m128i*)(s + n - 16));
+    if (n > 32) {
+      const s21_size_t skew = 16 - (s21_size_t)d % 16;
+      unsigned char* dst = d + skew;
+      const unsigned char* src = s + skew;
+      unsigned char* end = d + n - 16;
+      if (n >= nt_threshold) {
+        for (; dst < end; dst += 16, src += 16) {
+          _mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+        }
+        _mm_sfence();
+      } else {
+        for (; dst < end; dst += 16, src += 16) {
+          _mm_store_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+        }
+      }
+    }
+    _mm_storeu_si128((__m128i*)d, head);
+    _mm_storeu_si128((__m128i*)(d + n - 16), tail);
+  }
+}
+
+// копирование с конца для dest > src
+static void sse2_copy_backward(unsigned char* d, const unsigned char* s,
+                               s21_size_t n) {
+  if (n <= 32) {
+    sse2_copy_forward(d, s, n);
+  } else {
+    __m128i head = _mm_loadu_si128((const __m128i*)s);
+    __m128i tail = _mm_loadu_si128((const __m128i*)(s + n - 16));
+    unsigned char* dst = (unsigned char*)((s21_size_t)(d + n) / 16 * 16) - 16;
+    for (; dst > d; dst -= 16) {
+      _mm_store_si128((__m128i*)dst,
+                      _mm_loadu_si128((const __m128i*)(s + (dst - d))));
+    }
+    _mm_storeu_si128((__m128i*)d, head);
+    _mm_storeu_si128((__m128i*)(d + n - 16), tail);
+  }
+}
+
+static void* sse2_memcpy(void* dest, const void* src, s21_size_t n) {
+  sse2_copy_forward((unsigned char*)dest, (const unsigned char*)src, n);
+  return dest;
+}
+
+static void* sse2_memmove(void* dest, const void* src, s21_size_t n) {
+  unsigned char* d = (unsigned char*)dest;
+  const unsigned char* s = (const unsigned char*)src;
+
+  // без перекрытия или при dest < src подходит копирование вперёд
+  if ((s21_size_t)(d - s) >= n) {
+    sse2_copy_forward(d, s, n);
+  } else {
+    sse2_copy_backward(d, s, n);
+  }
+
+  return dest;
+}
+
+static void set_small(unsigned char* s, int c, s21_size_t n) {
+  const u64 value = 0x0101010101010101ULL * (unsigned char)c;
+  if (n >= 8) {
+    STORE(u64, s, value);
+    STORE(u64, s + n - 8, value);
+  } else if (n >= 4) {
+    STORE(u32, s, (u32)value);
+    STORE(u32, s + n - 4, (u32)value);
+  } else if (n >= 2) {
+    STORE(u16, s, (u16)value);
+    STORE(u16, s + n - 2, (u16)value);
+  } else if (n == 1) {
+    *s = (unsigned char)c;
+  }
+}
+
+static void* sse2_memset(void* str, int c, s21_size_t n) {
+  unsigned char* s = (unsigned char*)str;
+
+  if (n <= 16) {
+    set_small(s, c, n);
+  } else {
+    const __m128i value = _mm_set1_epi8((char)c);
+    if (n > 32) {
+      unsigned char* dst = s + 16 - (s21_size_t)s % 16;
+      unsigned char* end = s + n - 16;
+      if (n >= nt_threshold) {
+        for (; dst < end; dst += 16) {
+          _mm_stream_si128((__m128i*)dst, value);
+        }
+        _mm_sfence();
+      } else {
+        for (; dst < end; dst += 16) {
+          _mm_store_si128((__m128i*)dst, value);
+        }
+      }
+    }
+    _mm_storeu_si128((__m128i*)s, value);
+    _mm_storeu_si128((__m128i*)(s + n - 16), value);
+  }
+
+  return str;
+}
+
+/* Блоки читаются по выровненным адресам (loadu на выровненном адресе не
+медленнее load); биты байтов перед началом строки отбрасываются сдвигом
+маски. */
+S21_NO_ASAN static s21_size_t sse2_strlen(const char* str) {
+  const s21_size_t offset = (s21_size_t)str % 16;
+  const char* block = str - offset;
+  const __m128i zero = _mm_setzero_si128();
+
+  s21_size_t len;
+
+  unsigned mask = SSE2_MATCH(block, zero) >> offset;
+  if (mask) {
+    len = __builtin_ctz(mask);
+  } else {
+    do {
+      block += 16;
+      mask = SSE2_MATCH(block, zero);
+    } while (!mask);
+    len = block + __builtin_ctz(mask) - str;
+  }
+
+  return len;
+}
+
+// как sse2_strlen, но не дальше max байтов: блоки за max не читаются
+S21_NO_ASAN static s21_size_t sse2_strnlen(const char* str, s21_size_t max) {
+  const s21_size_t offset = (s21_size_t)str % 16;
+  const char* block = str - offset;
+  const __m128i zero = _mm_setzero_si128();
+
+  const char* found = str;  // начало блока, к которому относится mask
+
+  unsigned mask = SSE2_MATCH(block, zero) >> offset;
+  while (!mask && (s21_size_t)(block + 16 - str) < max) {
+    block += 16;
+    mask = SSE2_MATCH(block, zero);
+    found = block;
+  }
+  s21_size_t len = mask ? (s21_size_t)(found + __builtin_ctz(mask) - str) : max;
+
+  return len < max ? len : max;
+}
+
+AVX2 static void* avx2_memchr(const void* str, int c, s21_size_t n) {
+  const unsigned char* s = (const unsigned char*)str;
+  void* result = S21_NULL;
+
+  if (n < 32) {
+    result = sse2_memchr(str, c, n);
+  } else {
+    const __m256i needle = _mm256_set1_epi8((char)c);
+    const unsigned char* last = s + n - 32;
+    unsigned mask = 0;
+    while (s < last && !(mask = AVX2_MATCH(s, needle))) {
+      s += 32;
+    }
+    if (!mask) {
+      s = last;
+      mask = AVX2_MATCH(s, needle);
+    }
+    if (mask) {
+      result = (void*)(s + __builtin_ctz(mask));
+    }
+  }
+
+  return result;
+}
+
+AVX2 static int avx2_memcmp(const void* str1, const void* str2, s21_size_t n) {
+  const unsigned char* s1 = (const unsigned char*)str1;
+  const unsigned char* s2 = (const unsigned char*)str2;
+  int result = 0;
+
+  if (n < 32) {
+    result = sse2_memcmp(str1, str2, n);
+  } else {
+    s21_size_t i = 0;
+    unsigned diff = 0;
+    while (i < n - 32 && !(diff = AVX2_DIFF(s1 + i, s2 + i))) {
+      i += 32;
+    }
+    if (!diff) {
+      i = n - 32;
+      diff = AVX2_DIFF(s1 + i, s2 + i);
+    }
+    if (diff) {
+      i += __builtin_ctz(diff);
+      result = s1[i] - s2[i];
+    }
+  }
+
+  return result;
+}
+
+AVX2 static void avx2_copy_forward(unsigned char* d, const unsigned char* s,
+                                   s21_size_t n) {
+  if (n <= 32) {
+    sse2_copy_forward(d, s, n);
+  } else {
+    __m256i head = _mm256_loadu_si256((const __m256i*)s);
+    __m256i tail = _mm256_loadu_si256((const __m256i*)(s + n - 32));
+    if (n > 64) {
+      const s21_size_t skew = 32 - (s21_size_t)d % 32;
+      unsigned char* dst = d + skew;
+      const unsigned char* src = s + skew;
+      unsigned char* end = d + n - 32;
+      if (n >= nt_threshold) {
+        for (; dst < end; dst += 32, src += 32) {
+          _mm256_stream_si256((__m256i*)dst,
+                              _mm256_loadu_si256((const __m256i*)src));
+        }
+        _mm_sfence();
+      } else {
+        for (; dst < end; dst += 32, src += 32) {
+          _mm256_store_si256((__m256i*)dst,
+                             _mm256_loadu_si256((const __m256i*)src));
+        }
+      }
+    }
+    _mm256_storeu_si256((__m256i*)d, head);
+    _mm256_storeu_si256((__m256i*)(d + n - 32), tail);
+  }
+}
+
+AVX2 static void avx2_copy_backward(unsigned char* d, const unsigned char* s,
+                                    s21_size_t n) {
+  if (n <= 64) {
+    avx2_copy_forward(d, s, n);
+  } else {
+    __m256i head = _mm256_loadu_si256((const __m256i*)s);
+    __m256i tail = _mm256_loadu_si256((const __m256i*)(s + n - 32));
+    unsigned char* dst = (unsigned char*)((s21_size_t)(d + n) / 32 * 32) - 32;
+    for (; dst > d; dst -= 32) {
+      _mm256_store_si256((__m256i*)dst,
+                         _mm256_loadu_si256((const __m256i*)(s + (dst - d))));
+    }
+    _mm256_storeu_si256((__m256i*)d, head);
+    _mm256_storeu_si256((__m256i*)(d + n - 32), tail);
+  }
+}
+
+AVX2 static void* avx2_memcpy(void* dest, const void* src, s21_size_t n) {
+  avx2_copy_forward((unsigned char*)dest, (const unsigned char*)src, n);
+  return dest;
+}
+
+AVX2 static void* avx2_memmove(void* dest, const void* src, s21_size_t n) {
+  unsigned char* d = (unsigned char*)dest;
+  const unsigned char* s = (const unsigned char*)src;
+
+  if ((s21_size_t)(d - s) >= n) {
+    avx2_copy_forward(d, s, n);
+  } else {
+    avx2_copy_backward(d, s, n);
+  }
+
+  return dest;
+}
+
+AVX2 static void* avx2_memset(void* str, int c, s21_size_t n) {
+  unsigned char* s = (unsigned char*)str;
+
+  if (n <= 32) {
+    sse2_memset(str, c, n);
+  } else {
+    const __m256i value = _mm256_set1_epi8((char)c);
+    if (n > 64) {
+      unsigned char* dst = s + 32 - (s21_size_t)s % 32;
+      unsigned char* end = s + n - 32;
+      if (n >= nt_threshold) {
+        for (; dst < end; dst += 32) {
+          _mm256_stream_si256((__m256i*)dst, value);
+        }
+        _mm_sfence();
+      } else {
+        for (; dst < end; dst += 32) {
+          _mm256_store_si256((__m256i*)dst, value);
+        }
+      }
+    }
+    _mm256_storeu_si256((__m256i*)s, value);
+    _mm256_storeu_si256((__m256i*)(s + n - 32), value);
+  }
+
+  return str;
+}
+
+AVX2 S21_NO_ASAN static s21_size_t avx2_strlen(const char* str) {
+  const s21_size_t offset = (s21_size_t)str % 32;
+  const char* block = str - offset;
+  const __m256i zero = _mm256_setzero_si256();
+
+  s21_size_t len;
+
+  unsigned mask = AVX2_MATCH(block, zero) >> offset;
+  if (mask) {
+    len = __builtin_ctz(mask);
+  } else {
+    do {
+      block += 32;
+      mask = AVX2_MATCH(block, zero);
+    } while (!mask);
+    len = block + __builtin_ctz(mask) - str;
+  }
+
+  return len;
+}
+
+AVX2 S21_NO_ASAN static s21_size_t avx2_strnlen(const char* str,
+                                                s21_size_t max) {
+  const s21_size_t offset = (s21_size_t)str % 32;
+  const char* block = str - offset;
+  const __m256i zero = _mm256_setzero_si256();
+
+  const char* found = str;  // начало блока, к которому относится mask
+
+  unsigned mask = AVX2_MATCH(block, zero) >> offset;
+  while (!mask && (s21_size_t)(block + 32 - str) < max) {
+    block += 32;
+    mask = AVX2_MATCH(block, zero);
+    found = block;
+  }
+  s21_size_t len = mask ? (s21_size_t)(found + __builtin_ctz(mask) - str) : max;
+
+  return len < max ? len : max;
+}
+
+/* Смена регистра: после прибавления 128 - first буквы диапазона становятся
+26 самыми маленькими знаковыми байтами, поэтому их выделяет одно знаковое
+сравнение. Смена регистра идемпотентна, так что последний неполный блок
+обрабатывается перекрывающимся блоком, в том числе при dst == src. */
+#define SSE2_CASE(x, shift, limit)                                    \
+  _mm_xor_si128(                                                      \
+      x, _mm_and_si128(_mm_cmplt_epi8(_mm_add_epi8(x, shift), limit), \
+                       _mm_set1_epi8(0x20)))
+#define AVX2_CASE(x, shift, limit)                                \
+  _mm256_xor_si256(                                               \
+      x, _mm256_and_si256(                                        \
+             _mm256_cmpgt_epi8(limit, _mm256_add_epi8(x, shift)), \
+             _mm256_set1_epi8(0x20)))
+
+static void sse2_case_map(char* dst, const char* src, s21_size_t n,
+                          int upper) {
+  if (n < 16) {
+    s21_case_map_scalar(dst, src, n, upper);
+  } else {
+    const __m128i shift = _mm_set1_epi8((char)(128 - (upper ? 'a' : 'A')));
+    const __m128i limit = _mm_set1_epi8(-128 + 26);
+    __m128i tail = _mm_loadu_si128((const __m128i*)(src + n - 16));
+    for (s21_size_t i = 0; i < n - 16; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+      _mm_storeu_si128((__m128i*)(dst + i), SSE2_CASE(x, shift, limit));
+    }
+    _mm_storeu_si128((__m128i*)(dst + n - 16), SSE2_CASE(tail, shift, limit));
+  }
+}
+
+AVX2 static void avx2_case_map(char* dst, const char* src, s21_size_t n,
+                               int upper) {
+  if (n < 32) {
+    sse2_case_map(dst, src, n, upper);
+  } else {
+    const __m256i shift = _mm256_set1_epi8((char)(128 - (upper ? 'a' : 'A')));
+    const __m256i limit = _mm256_set1_epi8(-128 + 26);
+    __m256i tail = _mm256_loadu_si256((const __m256i*)(src + n - 32));
+    for (s21_size_t i = 0; i < n - 32; i += 32) {
+      __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+      _mm256_storeu_si256((__m256i*)(dst + i), AVX2_CASE(x, shift, limit));
+    }
+    _mm256_storeu_si256((__m256i*)(dst + n - 32),
+                        AVX2_CASE(tail, shift, limit));
+  }
+}
+
+/* Поиск по множеству байтов (s21_charset): младший полубайт каждого байта
+выбирает через pshufb байт таблицы (своей для половин 0-127 и 128-255),
+старший — бит в нём. */
+#define SSSE3 __attribute__((target("ssse3")))
+
+// маска остановки для блока по адресу p в поиске без терминатора
+#define SSSE3_SCAN_MASK(p)                                           \
+  ((unsigned)_mm_movemask_epi8(_mm_xor_si128(                        \
+      ssse3_members(_mm_loadu_si128((const __m128i*)(p)), low_table, \
+                    high_table),                                     \
+      invert)))
+#define AVX2_SCAN_MASK(p)                                              \
+  ((unsigned)_mm256_movemask_epi8(_mm256_xor_si256(                    \
+      avx2_members(_mm256_loadu_si256((const __m256i*)(p)), low_table, \
+                   high_table),                                        \
+      invert)))
+
+SSSE3 static inline __m128i ssse3_members(__m128i v, __m128i low_table,
+                                          __m128i high_table) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i bits =
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  __m128i low = _mm_and_si128(v, nibble);
+  __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+  __m128i upper_half = _mm_cmplt_epi8(v, _mm_setzero_si128());
+  __m128i rows = _mm_or_si128(
+      _mm_andnot_si128(upper_half, _mm_shuffle_epi8(low_table, low)),
+      _mm_and_si128(upper_half, _mm_shuffle_epi8(high_table, low)));
+  __m128i bit = _mm_shuffle_epi8(bits, high);
+  return _mm_cmpeq_epi8(_mm_and_si128(rows, bit), bit);
+}
+
+// маска байтов блока, на которых поиск по множеству должен остановиться
+SSSE3 S21_NO_ASAN static inline unsigned ssse3_stop_mask(
+    const char* block, __m128i low_table, __m128i high_table, __m128i invert) {
+  __m128i v = _mm_loadu_si128((const __m128i*)block);
+  __m128i stop = _mm_or_si128(
+      _mm_xor_si128(ssse3_members(v, low_table, high_table), invert),
+      _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+  return (unsigned)_mm_movemask_epi8(stop);
+}
+
+SSSE3 S21_NO_ASAN static s21_size_t ssse3_charset_scan(
+    const char* str, const s21_charset* set, int stop_on_member) {
+  const __m128i low_table = _mm_loadu_si128((const __m128i*)set->table);
+  const __m128i high_table = _mm_loadu_si128((const __m128i*)(set->table + 16));
+  const __m128i invert = stop_on_member ? _mm_setzero_si128()
+                                        : _mm_set1_epi8(-1);
+  const s21_size_t offset = (s21_size_t)str % 16;
+  const char* block = str - offset;
+  s21_size_t len;
+
+  unsigned mask =
+      ssse3_stop_mask(block, low_table, high_table, invert) >> offset;
+  if (mask) {
+    len = __builtin_ctz(mask);
+  } else {
+    do {
+      block += 16;
+      mask = ssse3_stop_mask(block, low_table, high_table, invert);
+    } while (!mask);
+    len = block + __builtin_ctz(mask) - str;
+  }
+
+  return len;
+}
+
+SSSE3 static s21_size_t ssse3_charset_scan_n(const char* str, s21_size_t n,
+                                             const s21_charset* set,
+                                             int stop_on_member) {
+  const __m128i low_table = _mm_loadu_si128((const __m128i*)set->table);
+  const __m128i high_table = _mm_loadu_si128((const __m128i*)(set->table + 16));
+  const __m128i invert = stop_on_member ? _mm_setzero_si128()
+                                        : _mm_set1_epi8(-1);
+  s21_size_t len = n;
+
+  if (n < 16) {
+    len = s21_charset_scan_n_scalar(str, n, set, stop_on_member);
+  } else {
+    const char* p = str;
+    const char* last = str + n - 16;
+    unsigned mask = 0;
+    while (p < last && !(mask = SSSE3_SCAN_MASK(p))) {
+      p += 16;
+    }
+    if (!mask) {
+      p = last;
+      mask = SSSE3_SCAN_MASK(p);
+    }
+    if (mask) {
+      len = p + __builtin_ctz(mask) - str;
+    }
+  }
+
+  return len;
+}
+
+AVX2 static inline __m256i avx2_members(__m256i v, __m256i low_table,
+                                        __m256i high_table) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i bits = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+      16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  __m256i low = _mm256_and_si256(v, nibble);
+  __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+  __m256i upper_half = _mm256_cmpgt_epi8(_mm256_setzero_si256(), v);
+  __m256i rows = _mm256_blendv_epi8(_mm256_shuffle_epi8(low_table, low),
+                                    _mm256_shuffle_epi8(high_table, low),
+                                    upper_half);
+  __m256i bit = _mm256_shuffle_epi8(bits, high);
+  return _mm256_cmpeq_epi8(_mm256_and_si256(rows, bit), bit);
+}
+
+AVX2 S21_NO_ASAN static inline unsigned avx2_stop_mask(
+    const char* block, __m256i low_table, __m256i high_table, __m256i invert) {
+  __m256i v = _mm256_loadu_si256((const __m256i*)block);
+  __m256i stop = _mm256_or_si256(
+      _mm256_xor_si256(avx2_members(v, low_table, high_table), invert),
+      _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+  return (unsigned)_mm256_movemask_epi8(stop);
+}
+
+AVX2 S21_NO_ASAN static s21_size_t avx2_charset_scan(const char* str,
+                                                     const s21_charset* set,
+                                                     int stop_on_member) {
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)set->table));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)(set->table + 16)));
+  const __m256i invert = stop_on_member ? _mm256_setzero_si256()
+                                        : _mm256_set1_epi8(-1);
+  const s21_size_t offset = (s21_size_t)str % 32;
+  const char* block = str - offset;
+  s21_size_t len;
+
+  unsigned mask =
+      avx2_stop_mask(block, low_table, high_table, invert) >> offset;
+  if (mask) {
+    len = __builtin_ctz(mask);
+  } else {
+    do {
+      block += 32;
+      mask = avx2_stop_mask(block, low_table, high_table, invert);
+    } while (!mask);
+    len = block + __builtin_ctz(mask) - str;
+  }
+
+  return len;
+}
+
+AVX2 static s21_size_t avx2_charset_scan_n(const char* str, s21_size_t n,
+                                           const s21_charset* set,
+                                           int stop_on_member) {
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)set->table));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)(set->table + 16)));
+  const __m256i invert = stop_on_member ? _mm256_setzero_si256()
+                                        : _mm256_set1_epi8(-1);
+  s21_size_t len = n;
+
+  if (n < 32) {
+    len = ssse3_charset_scan_n(str, n, set, stop_on_member);
+  } else {
+    const char* p = str;
+    const char* last = str + n - 32;
+    unsigned mask = 0;
+    while (p < last && !(mask = AVX2_SCAN_MASK(p))) {
+      p += 32;
+    }
+    if (!mask) {
+      p = last;
+      mask = AVX2_SCAN_MASK(p);
+    }
+    if (mask) {
+      len = p + __builtin_ctz(mask) - str;
+    }
+  }
+
+  return len;
+}
+
+/* Проверка UTF-8 по таблицам (Keiser, Lemire, "Validating UTF-8 in less
+than one instruction per byte"). Для каждого байта pshufb по старшему и
+младшему полубайтам предыдущего байта и по старшему полубайту текущего
+выбирают битовые маски ошибок, возможных в этой паре; пересечение трёх
+масок не пусто ровно у неправильных пар. Исключение — два продолжения
+подряд: они нужны после трёх- и четырёхбайтовых начал, что проверяется по
+байтам на две и три позиции раньше. Блок, где нашлась ошибка, и неполный
+последний блок проверяются скалярно с начала последовательности, в которую
+попадает начало блока, — так находится точное смещение. */
+#define UTF8_TOO_SHORT (1 << 0)       // 11______ 0_______, 11______ 11______
+#define UTF8_TOO_LONG (1 << 1)        // 0_______ 10______
+#define UTF8_OVERLONG_3 (1 << 2)      // 11100000 100_____
+#define UTF8_TOO_LARGE (1 << 3)       // 11110100 1001____, 11110101 и выше
+#define UTF8_SURROGATE (1 << 4)       // 11101101 101_____
+#define UTF8_OVERLONG_2 (1 << 5)      // 1100000_ 10______
+#define UTF8_TOO_LARGE_1000 (1 << 6)  // 11110101 1000____ и выше
+#define UTF8_OVERLONG_4 (1 << 6)      // 11110000 1000____
+#define UTF8_TWO_CONTS (1 << 7)       // 10______ 10______
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// таблицы по полубайтам: старший предыдущего, младший предыдущего,
+// старший текущего байта
+#define UTF8_BYTE_1_HIGH                                                    \
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, \
+      UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TWO_CONTS,           \
+      UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,                        \
+      UTF8_TOO_SHORT | UTF8_OVERLONG_2, UTF8_TOO_SHORT,                      \
+      UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,                     \
+      UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+#define UTF8_BYTE_1_LOW                                                      \
+  UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,          \
+      UTF8_CARRY | UTF8_OVERLONG_2, UTF8_CARRY, UTF8_CARRY,                  \
+      UTF8_CARRY | UTF8_TOO_LARGE,                                           \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,    \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,                     \
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+#define UTF8_BYTE_2_HIGH                                                      \
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,             \
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,         \
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |    \
+          UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,                              \
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |    \
+          UTF8_TOO_LARGE,                                                     \
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |     \
+          UTF8_TOO_LARGE,                                                     \
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |     \
+          UTF8_TOO_LARGE,                                                     \
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+
+/* Начало последовательности, в которую попадает позиция i: ближайший
+ведущий байт не дальше чем за три байта до i, иначе сама i. */
+static s21_size_t utf8_restart(const char* str, s21_size_t i) {
+  s21_size_t k = 1;
+  while (k <= 3 && k <= i && ((unsigned char)str[i - k] & 0xC0) == 0x80) {
+    k++;
+  }
+  return k <= 3 && k <= i && (unsigned char)str[i - k] >= 0xC0 ? i - k : i;
+}
+
+// маска ошибок блока input, prev — предыдущий блок
+SSSE3 static inline __m128i ssse3_utf8_errors(__m128i input, __m128i prev) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i byte_1_high = _mm_setr_epi8(UTF8_BYTE_1_HIGH);
+  const __m128i byte_1_low = _mm_setr_epi8(UTF8_BYTE_1_LOW);
+  const __m128i byte_2_high = _mm_setr_epi8(UTF8_BYTE_2_HIGH);
+  __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+  __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+  __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+
+  __m128i special = _mm_and_si128(
+      _mm_and_si128(
+          _mm_shuffle_epi8(byte_1_high,
+                           _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+          _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+      _mm_shuffle_epi8(byte_2_high,
+                       _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+  // старший бит — за два байта до этого начало 1110____ или за три 11110___
+  __m128i must_continue = _mm_and_si128(
+      _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                   _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80))),
+      _mm_set1_epi8(-128));
+  return _mm_xor_si128(must_continue, special);
+}
+
+SSSE3 static s21_size_t ssse3_utf8_validate(const char* str, s21_size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i prev = zero;
+  s21_size_t i = 0;
+  int valid = 1;
+
+  while (valid && n - i >= 16) {
+    __m128i input = _mm_loadu_si128((const __m128i*)(str + i));
+    // ASCII после ASCII: проверять нечего
+    if (_mm_movemask_epi8(_mm_or_si128(input, prev)) != 0) {
+      __m128i errors = ssse3_utf8_errors(input, prev);
+      valid = _mm_movemask_epi8(_mm_cmpeq_epi8(errors, zero)) == 0xFFFF;
+    }
+    if (valid) {
+      prev = input;
+      i += 16;
+    }
+  }
+
+  i = utf8_restart(str, i);
+  return i + s21_utf8_validate_scalar(str + i, n - i);
+}
+
+AVX2 static inline __m256i avx2_utf8_errors(__m256i input, __m256i prev) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i byte_1_high =
+      _mm256_setr_epi8(UTF8_BYTE_1_HIGH, UTF8_BYTE_1_HIGH);
+  const __m256i byte_1_low = _mm256_setr_epi8(UTF8_BYTE_1_LOW, UTF8_BYTE_1_LOW);
+  const __m256i byte_2_high =
+      _mm256_setr_epi8(UTF8_BYTE_2_HIGH, UTF8_BYTE_2_HIGH);
+  // верхняя половина prev и нижняя input: сдвиг через границу половин
+  __m256i joined = _mm256_permute2x128_si256(prev, input, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(input, joined, 15);
+  __m256i prev2 = _mm256_alignr_epi8(input, joined, 14);
+  __m256i prev3 = _mm256_alignr_epi8(input, joined, 13);
+
+  __m256i special = _mm256_and_si256(
+      _mm256_and_si256(
+          _mm256_shuffle_epi8(
+              byte_1_high,
+              _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+          _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+      _mm256_shuffle_epi8(
+          byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+  __m256i must_continue = _mm256_and_si256(
+      _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+                      _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80))),
+      _mm256_set1_epi8(-128));
+  return _mm256_xor_si256(must_continue, special);
+}
+
+AVX2 static s21_size_t avx2_utf8_validate(const char* str, s21_size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i prev = zero;
+  s21_size_t i = 0;
+  int valid = 1;
+
+  while (valid && n - i >= 32) {
+    __m256i input = _mm256_loadu_si256((const __m256i*)(str + i));
+    if (_mm256_movemask_epi8(_mm256_or_si256(input, prev)) != 0) {
+      __m256i errors = avx2_utf8_errors(input, prev);
+      valid = _mm256_testz_si256(errors, errors);
+    }
+    if (valid) {
+      prev = input;
+      i += 32;
+    }
+  }
+
+  i = utf8_restart(str, i);
+  return i + s21_utf8_validate_scalar(str + i, n - i);
+}
+
+/* Подсчёт символов: байт — начало символа, если как знаковый он больше
+(char)0xBF. Сравнения (-1) вычитаются из байтовых счётчиков не больше 255
+раз подряд, затем psadbw складывает счётчики. */
+static s21_size_t sse2_utf8_len(const char* str, s21_size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i last_continuation = _mm_set1_epi8((char)0xBF);
+  s21_size_t count = 0;
+  s21_size_t i = 0;
+
+  while (n - i >= 16) {
+    s21_size_t blocks = (n - i) / 16 < 255 ? (n - i) / 16 : 255;
+    __m128i counters = zero;
+    for (s21_size_t b = 0; b < blocks; b++, i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+      counters =
+          _mm_sub_epi8(counters, _mm_cmpgt_epi8(v, last_continuation));
+    }
+    __m128i sums = _mm_sad_epu8(counters, zero);
+    count += (s21_size_t)_mm_cvtsi128_si64(sums) +
+             (s21_size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+  }
+
+  return count + s21_utf8_len_scalar(str + i, n - i);
+}
+
+AVX2 static s21_size_t avx2_utf8_len(const char* str, s21_size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i last_continuation = _mm256_set1_epi8((char)0xBF);
+  s21_size_t count = 0;
+  s21_size_t i = 0;
+
+  while (n - i >= 32) {
+    s21_size_t blocks = (n - i) / 32 < 255 ? (n - i) / 32 : 255;
+    __m256i counters = zero;
+    for (s21_size_t b = 0; b < blocks; b++, i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+      counters = _mm256_sub_epi8(counters,
+                                 _mm256_cmpgt_epi8(v, last_continuation));
+    }
+    __m256i sums = _mm256_sad_epu8(counters, zero);
+    count += (s21_size_t)_mm256_extract_epi64(sums, 0) +
+             (s21_size_t)_mm256_extract_epi64(sums, 1) +
+             (s21_size_t)_mm256_extract_epi64(sums, 2) +
+             (s21_size_t)_mm256_extract_epi64(sums, 3);
+  }
+
+  return count + sse2_utf8_len(str + i, n - i);
+}
+
+/* Размер самого большого кэша по cpuid (лист 4 у Intel, 0x8000001D у AMD),
+0 если процессор его не сообщает. */
+static s21_size_t largest_cache_size(void) {
+  const unsigned leaves[] = {4, 0x8000001D};
+  s21_size_t largest = 0;
+
+  for (int l = 0; l < 2; l++) {
+    unsigned a, b, c, d;
+    for (unsigned i = 0;
+         __get_cpuid_count(leaves[l], i, &a, &b, &c, &d) && (a & 0x1F) != 0;
+         i++) {
+      s21_size_t ways = ((b >> 22) & 0x3FF) + 1;
+      s21_size_t partitions = ((b >> 12) & 0x3FF) + 1;
+      s21_size_t line = (b & 0xFFF) + 1;
+      s21_size_t size = ways * partitions * line * ((s21_size_t)c + 1);
+      if (size > largest) {
+        largest = size;
+      }
+    }
+  }
+
+  return largest;
+}
+
+s21_impl s21_dispatch = {sse2_memchr,  sse2_memcmp,  sse2_memcpy,
+                         sse2_memset,  sse2_memmove, sse2_strlen,
+                         sse2_strnlen,
+                         s21_charset_scan_scalar,
+                         s21_charset_scan_n_scalar,
+                         sse2_case_map,
+                         s21_utf8_validate_scalar,
+                         sse2_utf8_len};
+
+/* Выбор реализаций один раз при запуске программы, до main. До этого момента
+(например, из чужих конструкторов) работают SSE2-версии. */
+__attribute__((constructor)) static void s21_dispatch_init(void) {
+  s21_size_t cache = largest_cache_size();
+  if (cache != 0) {
+    nt_threshold = cache / 4 * 3;
+  }
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3")) {
+    s21_dispatch.charset_scan = ssse3_charset_scan;
+    s21_dispatch.charset_scan_n = ssse3_charset_scan_n;
+    s21_dispatch.utf8_validate = ssse3_utf8_validate;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    s21_dispatch.memchr = avx2_memchr;
+    s21_dispatch.memcmp = avx2_memcmp;
+    s21_dispatch.memcpy = avx2_memcpy;
+    s21_dispatch.memset = avx2_memset;
+    s21_dispatch.memmove = avx2_memmove;
+    s21_dispatch.strlen = avx2_strlen;
+    s21_dispatch.strnlen = avx2_strnlen;
+    s21_dispatch.charset_scan = avx2_charset_scan;
+    s21_dispatch.charset_scan_n = avx2_charset_scan_n;
+    s21_dispatch.case_map = avx2_case_map;
+    s21_dispatch.utf8_validate = avx2_utf8_validate;
+    s21_dispatch.utf8_len = avx2_utf8_len;
+  }
+}
+
+#else
+
+s21_impl s21_dispatch = {s21_memchr_scalar,  s21_memcmp_scalar,
+                         s21_memcpy_scalar,  s21_memset_scalar,
+                         s21_memmove_scalar, s21_strlen_scalar,
+                         s21_strnlen_scalar,
+                         s21_charset_scan_scalar,
+                         s21_charset_scan_n_scalar,
+                         s21_case_map_scalar,
+                         s21_utf8_validate_scalar,
+                         s21_utf8_len_scalar};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef S21_SIMD_H
+#define S21_SIMD_H
+
+#include "s21_string.h"
+
+/* Внутренний заголовок: таблица реализаций, которую s21_simd.c при запуске
+заполняет векторными версиями по возможностям процессора (cpuid). Пока выбор
+не сделан (или процессор не x86-64), в ней стоят переносимые версии из
+s21_string.c. */
+
+/* Векторные функции для C-строк читают выровненные блоки, захватывающие байты
+за концом строки (но не за границей страницы). */
+#if defined(__SANITIZE_ADDRESS__)
+#define S21_NO_ASAN __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define S21_NO_ASAN __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef S21_NO_ASAN
+#define S21_NO_ASAN
+#endif
+
+typedef struct s21_impl {
+  void* (*memchr)(const void* str, int c, s21_size_t n);
+  int (*memcmp)(const void* str1, const void* str2, s21_size_t n);
+  void* (*memcpy)(void* dest, const void* src, s21_size_t n);
+  void* (*memset)(void* str, int c, s21_size_t n);
+  void* (*memmove)(void* dest, const void* src, s21_size_t n);
+  s21_size_t (*strlen)(const char* str);
+  s21_size_t (*strnlen)(const char* str, s21_size_t max);
+  s21_size_t (*charset_scan)(const char* str, const s21_charset* set,
+                             int stop_on_member);
+  s21_size_t (*charset_scan_n)(const char* str, s21_size_t n,
+                               const s21_charset* set, int stop_on_member);
+  // смена регистра ASCII-букв (upper != 0 — в верхний), dst == src допустимо
+  void (*case_map)(char* dst, const char* src, s21_size_t n, int upper);
+  s21_size_t (*utf8_validate)(const char* str, s21_size_t n);
+  s21_size_t (*utf8_len)(const char* str, s21_size_t n);
+} s21_impl;
+
+extern s21_impl s21_dispatch;
+
+void* s21_memchr_scalar(const void* str, int c, s21_size_t n);
+int s21_memcmp_scalar(const void* str1, const void* str2, s21_size_t n);
+void* s21_memcpy_scalar(void* dest, const void* src, s21_size_t n);
+void* s21_memset_scalar(void* str, int c, s21_size_t n);
+void* s21_memmove_scalar(void* dest, const void* src, s21_size_t n);
+s21_size_t s21_strlen_scalar(const char* str);
+s21_size_t s21_strnlen_scalar(const char* str, s21_size_t max);
+s21_size_t s21_charset_scan_scalar(const char* str, const s21_charset* set,
+                                   int stop_on_member);
+s21_size_t s21_charset_scan_n_scalar(const char* str, s21_size_t n,
+                                     const s21_charset* set,
+                                     int stop_on_member);
+void s21_case_map_scalar(char* dst, const char* src, s21_size_t n, int upper);
+s21_size_t s21_utf8_validate_scalar(const char* str, s21_size_t n);
+s21_size_t s21_utf8_len_scalar(const char* str, s21_size_t n);
+
+#endif
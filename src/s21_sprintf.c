@@ -1,16 +1,33 @@
+#include <limits.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "s21_dtoa.h"
+#include "s21_rows.h"
+#include "s21_simd.h"
 #include "s21_string.h"
 
-#define BUF_SIZE 1024
+// code points of %ls checked for ASCII at once
+#define WIDE_BLOCK 8
 
-// smaller buffer for intermediate calculations
-#define SBUF_SIZE 256
+// 64-bit word over wchar_t storage, whatever the width of long
+#if defined(__GNUC__)
+typedef unsigned long long __attribute__((__may_alias__)) wide_word;
+#else
+typedef unsigned long long wide_word;
+#endif
 
-#define EPSILON 1e-17L
+// staging buffer of s21_sink_printf
+#define SINK_BUFFER_SIZE 512
+
+// first attempt of s21_asprintf, so short strings are formatted once
+#define ASPRINTF_STACK_SIZE 256
+
+// Digits of a double kept on the stack: enough for the whole exact
+// expansion of any double (767 significant digits at most).
+#define DIGITS_SIZE 800
 
 typedef struct settings {
   // Flags
@@ -22,10 +39,12 @@ typedef struct settings {
 
   // Width
   bool set_width;
+  bool width_arg;  // '*'
   int width;
 
   // Precision
   bool set_precision;
+  bool precision_arg;  // '*'
   int precision;
 
   // Length
@@ -37,54 +56,139 @@ typedef struct settings {
   char specifier;
 } settings;
 
-void insert_inplace(char* buf, const char* str, s21_size_t start_index);
-void to_upper_inplace(char* buf);
+// Destination of a formatting call. Bytes past `cap - 1` are counted in `len`
+// but not stored, so `len` is always the length of the complete output.
+// With a sink, `dst` is a staging buffer that is handed to the sink whenever
+// it fills up; `base` is then the output offset of dst[0].
+typedef struct output {
+  char* dst;
+  s21_size_t cap;
+  s21_size_t len;
+  s21_size_t base;
+  const s21_sink* sink;
+  bool failed;  // a sink write failed
+} output;
+
+// A conversion of a compiled format with the literal text before it; the
+// last item may have no conversion (specifier 0).
+typedef struct format_item {
+  const char* literal;
+  s21_size_t literal_len;
+  settings settings;
+} format_item;
+
+// A conversion of s21_format_rows bound to its column. The kernel is picked
+// once per call, so the row loop neither reads a va_list nor dispatches on
+// the specifier.
+typedef struct row_cell {
+  const format_item* item;
+  const s21_column* column;
+  int (*emit)(output* out, const settings* settings, const s21_column* column,
+              s21_size_t row);
+} row_cell;
+
+// Compiled format: the items, followed in the same block by the literal
+// text they point to (with "%%" already reduced to "%").
+struct s21_format {
+  const s21_allocator* allocator;
+  s21_size_t count;
+  format_item items[];
+};
+
 bool is_digit(char c);
 int read_int(const char** format, int* value);
 void read_flags(const char** format, settings* settings);
-void read_width(const char** format, settings* settings, va_list ap);
-void read_precision(const char** format, settings* settings, va_list ap);
+void read_width(const char** format, settings* settings);
+void read_precision(const char** format, settings* settings);
+void read_star_args(settings* settings, va_list ap);
 void read_length(const char** format, settings* settings);
 void read_specifier(const char** format, settings* settings);
-void read_settings(const char** format, settings* settings, va_list ap);
-int handle_char(char* buf, const settings* settings, va_list ap);
-void handle_int_precision(char** ptmp, const settings* settings, int written);
-void int_to_str(char* buf, const settings* settings, long value);
-void unsigned_int_to_str(char* buf, settings* settings, unsigned long value,
-                         int base);
-void handle_int(char* buf, const settings* settings, va_list ap);
-void handle_unsigned_int(char* buf, settings* settings, va_list ap, int base);
+void read_settings(const char** format, settings* settings);
+int bit_length(unsigned long value);
+s21_size_t count_digits(unsigned long value, int base);
+void write_decimal(char* end, unsigned long value);
+void write_power2(char* end, unsigned long value, int shift,
+                  const char* table);
+void write_digits(char* end, unsigned long value, int base, const char* table);
+s21_size_t sign_prefix(char* prefix, const settings* settings, bool negative);
+s21_size_t field_open(output* out, const settings* settings, const char* prefix,
+                      s21_size_t prefix_len, s21_size_t zeroes,
+                      s21_size_t body_len, bool zero_pad);
+void emit_field(output* out, const settings* settings, const char* prefix,
+                s21_size_t prefix_len, s21_size_t zeroes, const char* body,
+                s21_size_t body_len, bool zero_pad);
+s21_size_t int_zeroes(const settings* settings, s21_size_t digits);
+void emit_integer(output* out, const settings* settings, const char* prefix,
+                  s21_size_t prefix_len, unsigned long value, int base,
+                  const char* table);
+void emit_int(output* out, const settings* settings, long value);
+void emit_unsigned(output* out, const settings* settings, unsigned long value);
 int double_get_precision(const settings* settings);
-int normalize_double(long double* value);
-void frac_to_str(char** ptmp, const settings* settings, long double value);
-void double_handle_sign(char** ptmp, const settings* settings,
-                        long double* value);
-void double_to_str(char* buf, const settings* settings, long double value);
-void double_to_str_e(char* buf, const settings* settings, long double value);
-void remove_trailing_zeroes(char* buf, bool scientific);
-void handle_double_shortest(char* buf, const settings* settings,
-                            long double value);
-void handle_double(char* buf, const settings* settings, va_list ap);
-int handle_str(char* buf, const settings* settings, va_list ap);
-void handle_prefix(char* buf, const settings* settings);
-void handle_pointer(char* buf, settings* settings, va_list ap);
-int arg_to_str(char* buf, settings* settings, va_list ap);
-void copy_with_width(char** str, const char* buf, const settings* settings);
+char exponent_char(const settings* settings);
+void emit_nonfinite(output* out, const settings* settings, const char* prefix,
+                    s21_size_t prefix_len, long double value);
+void emit_fixed(output* out, const settings* settings, const char* prefix,
+                s21_size_t prefix_len, const s21_decimal* dec, int precision);
+void emit_scientific(output* out, const settings* settings,
+                     const char* prefix, s21_size_t prefix_len,
+                     const s21_decimal* dec, int precision);
+void emit_general(output* out, const settings* settings, const char* prefix,
+                  s21_size_t prefix_len, s21_decimal* dec, int precision);
+int emit_double(output* out, const settings* settings, long double value);
+void emit_str(output* out, const settings* settings, const char* str,
+              s21_size_t len);
+int utf8_length(wchar_t c);
+int utf8_encode(char* dst, wchar_t c);
+s21_size_t wide_ascii_run(const wchar_t* str, s21_size_t max);
+s21_size_t utf8_encode_run(char* dst, const wchar_t* str, s21_size_t count);
+int emit_wide_char(output* out, const settings* settings, wchar_t c);
+int emit_wide_str(output* out, const settings* settings, const wchar_t* str);
+long int_arg(const settings* settings, va_list ap);
+unsigned long unsigned_arg(const settings* settings, va_list ap);
+int emit_arg(output* out, const settings* settings, va_list ap);
+void out_flush(output* out);
+void sink_write(output* out, const char* src, s21_size_t n);
+void out_write(output* out, const char* src, s21_size_t n);
+void out_fill(output* out, char c, s21_size_t n);
+char* out_direct(output* out, s21_size_t n);
+void out_finish(output* out);
+int out_result(output* out, int err);
+int format_to(output* out, const char* format, va_list ap);
 int s21_sprintf(char* str, const char* format, ...);
-
-void insert_inplace(char* buf, const char* str, s21_size_t start_index) {
-  char* new_str = s21_insert(buf, str, start_index);
-  int len = s21_strlen(new_str);
-  s21_strncpy(buf, new_str, len + 1);
-  free(new_str);
-}
-
-void to_upper_inplace(char* buf) {
-  char* new_str = s21_to_upper(buf);
-  int len = s21_strlen(new_str);
-  s21_strncpy(buf, new_str, len + 1);
-  free(new_str);
-}
+int s21_snprintf(char* str, s21_size_t size, const char* format, ...);
+int s21_vsprintf(char* str, const char* format, va_list ap);
+int s21_vsnprintf(char* str, s21_size_t size, const char* format,
+                  va_list ap);
+int s21_sink_printf(const s21_sink* sink, const char* format, ...);
+int s21_sink_vprintf(const s21_sink* sink, const char* format, va_list ap);
+int s21_asprintf(char** strp, const char* format, ...);
+int s21_vasprintf(char** strp, const char* format, va_list ap);
+s21_size_t s21_dtoa(char* str, double value);
+s21_format* s21_format_compile(const char* format);
+void s21_format_free(s21_format* format);
+int format_compiled_to(output* out, const s21_format* format, va_list ap);
+int s21_sprintf_compiled(char* str, const s21_format* format, va_list ap);
+int s21_snprintf_compiled(char* str, s21_size_t size, const s21_format* format,
+                          va_list ap);
+int cell_long(output* out, const settings* settings, const s21_column* column,
+              s21_size_t row);
+int cell_unsigned(output* out, const settings* settings,
+                  const s21_column* column, s21_size_t row);
+int cell_char(output* out, const settings* settings, const s21_column* column,
+              s21_size_t row);
+int cell_double(output* out, const settings* settings,
+                const s21_column* column, s21_size_t row);
+int cell_string(output* out, const settings* settings,
+                const s21_column* column, s21_size_t row);
+int bind_cells(row_cell* cells, const s21_format* format,
+               const s21_column* columns);
+int s21_format_row_range(char* str, s21_size_t size, const s21_format* format,
+                         const s21_column* columns, s21_size_t first,
+                         s21_size_t last, s21_size_t* offsets,
+                         s21_size_t* len);
+int s21_format_rows(char* str, s21_size_t size, const s21_format* format,
+                    const s21_column* columns, s21_size_t rows,
+                    s21_size_t* offsets);
 
 bool is_digit(char c) { return c >= '0' && c <= '9'; }
 
@@ -132,10 +236,9 @@ void read_flags(const char** format, settings* settings) {
   }
 }
 
-void read_width(const char** format, settings* settings, va_list ap) {
+void read_width(const char** format, settings* settings) {
   if (**format == '*') {
-    settings->set_width = true;
-    settings->width = va_arg(ap, int);
+    settings->width_arg = true;
     (*format)++;
   } else {
     int status = read_int(format, &settings->width);
@@ -145,12 +248,12 @@ void read_width(const char** format, settings* settings, va_list ap) {
   }
 }
 
-void read_precision(const char** format, settings* settings, va_list ap) {
+void read_precision(const char** format, settings* settings) {
   if (**format == '.') {
     (*format)++;
     settings->set_precision = true;
     if (**format == '*') {
-      settings->precision = va_arg(ap, int);
+      settings->precision_arg = true;
       (*format)++;
     } else {
       settings->precision = 0;
@@ -159,6 +262,24 @@ void read_precision(const char** format, settings* settings, va_list ap) {
   }
 }
 
+// takes the width and precision given as '*' from the arguments
+void read_star_args(settings* settings, va_list ap) {
+  if (settings->width_arg) {
+    settings->set_width = true;
+    settings->width = va_arg(ap, int);
+    // a negative width argument means '-' flag and a positive width
+    if (settings->width < 0) {
+      settings->left_justify = true;
+      settings->width = -settings->width;
+    }
+  }
+  if (settings->precision_arg) {
+    settings->precision = va_arg(ap, int);
+    // a negative precision argument is taken as if it were omitted
+    settings->set_precision = settings->precision >= 0;
+  }
+}
+
 void read_length(const char** format, settings* settings) {
   if (**format == 'h') {
     settings->short_int = true;
@@ -174,107 +295,226 @@ void read_length(const char** format, settings* settings) {
 
 void read_specifier(const char** format, settings* settings) {
   settings->specifier = **format;
-  (*format)++;
+  if (**format) {
+    (*format)++;
+  }
 }
 
-void read_settings(const char** format, settings* settings, va_list ap) {
+// parses a conversion after its '%' (the '*' arguments are not taken yet)
+void read_settings(const char** format, settings* settings) {
   read_flags(format, settings);
-  read_width(format, settings, ap);
-  read_precision(format, settings, ap);
+  read_width(format, settings);
+  read_precision(format, settings);
   read_length(format, settings);
   read_specifier(format, settings);
 }
 
-int handle_char(char* buf, const settings* settings, va_list ap) {
-  int status = 0;
-  if (!settings->long_int) {
-    char value = va_arg(ap, int);
-    buf[0] = value;
-    buf[1] = 0;
+static const char digit_pairs[201] =
+    "000102030405060708091011121314151617181920212223242526272829"
+    "303132333435363738394041424344454647484950515253545556575859"
+    "606162636465666768697071727374757677787980818283848586878889"
+    "90919293949596979899";
+
+static const unsigned long powers_of_10[20] = {1UL,
+                                               10UL,
+                                               100UL,
+                                               1000UL,
+                                               10000UL,
+                                               100000UL,
+                                               1000000UL,
+                                               10000000UL,
+                                               100000000UL,
+                                               1000000000UL,
+                                               10000000000UL,
+                                               100000000000UL,
+                                               1000000000000UL,
+                                               10000000000000UL,
+                                               100000000000000UL,
+                                               1000000000000000UL,
+                                               10000000000000000UL,
+                                               100000000000000000UL,
+                                               1000000000000000000UL,
+                                               10000000000000000000UL};
+
+// number of significant bits (0 for 0)
+int bit_length(unsigned long value) {
+#if defined(__GNUC__)
+  return value ? (int)(sizeof(value) * 8) - __builtin_clzl(value) : 0;
+#else
+  int bits = 0;
+  for (; value; value >>= 1) {
+    bits++;
+  }
+  return bits;
+#endif
+}
+
+// Digits needed for `value` in base 8, 10 or 16, derived from its bit
+// length. Zero has no digits: the precision supplies them.
+s21_size_t count_digits(unsigned long value, int base) {
+  int bits = bit_length(value);
+  s21_size_t n;
+  if (base == 16) {
+    n = (bits + 3) / 4;
+  } else if (base == 8) {
+    n = (bits + 2) / 3;
   } else {
-    long c = va_arg(ap, long);
-    int wstatus = wctomb(buf, c);
-    if (wstatus != -1) {
-      buf[wstatus] = 0;
-    } else {
-      status = -1;
-    }
+    // 1233 / 4096 ~ log10(2): an estimate that is at most one digit short
+    int t = bits * 1233 >> 12;
+    n = t + (bits > 0 && value >= powers_of_10[t]);
   }
-  return status;
+  return n;
 }
 
-void handle_int_precision(char** ptmp, const settings* settings, int written) {
-  int precision = 1;
-  if (settings->set_precision) {
-    precision = settings->precision;
+// The writers below fill the digits backwards so that the last one lands
+// right before `end`; the caller has counted them with count_digits.
+void write_decimal(char* end, unsigned long value) {
+  while (value >= 100) {
+    const char* pair = digit_pairs + value % 100 * 2;
+    value /= 100;
+    *--end = pair[1];
+    *--end = pair[0];
   }
-  while (written < precision) {
-    *(*ptmp)-- = '0';
-    written++;
+  if (value >= 10) {
+    *--end = digit_pairs[value * 2 + 1];
+    *--end = digit_pairs[value * 2];
+  } else if (value > 0) {
+    *--end = (char)('0' + value);
   }
 }
 
-void int_to_str(char* buf, const settings* settings, long value) {
-  char tmp[SBUF_SIZE] = "";
-  bool negative = value < 0 ? true : false;
-  char* ptmp = tmp + SBUF_SIZE - 2;
+void write_power2(char* end, unsigned long value, int shift,
+                  const char* table) {
+  const unsigned long mask = (1UL << shift) - 1;
+  for (; value; value >>= shift) {
+    *--end = table[value & mask];
+  }
+}
 
-  while (value != 0) {
-    *ptmp-- = '0' + labs(value % 10);
-    value /= 10;
+void write_digits(char* end, unsigned long value, int base, const char* table) {
+  if (base == 10) {
+    write_decimal(end, value);
+  } else {
+    write_power2(end, value, base == 16 ? 4 : 3, table);
   }
-  handle_int_precision(&ptmp, settings, tmp + SBUF_SIZE - 2 - ptmp);
+}
 
+s21_size_t sign_prefix(char* prefix, const settings* settings, bool negative) {
+  s21_size_t len = 1;
   if (negative) {
-    *ptmp-- = '-';
+    *prefix = '-';
   } else if (settings->force_sign) {
-    *ptmp-- = '+';
+    *prefix = '+';
   } else if (settings->force_space) {
-    *ptmp-- = ' ';
+    *prefix = ' ';
+  } else {
+    len = 0;
   }
-  s21_strncpy(buf, ptmp + 1, s21_strlen(ptmp + 1) + 1);
+  return len;
 }
 
-void unsigned_int_to_str(char* buf, settings* settings, unsigned long value,
-                         int base) {
-  char tmp[SBUF_SIZE] = "";
-  char* ptmp = tmp + SBUF_SIZE - 2;
+// Opens a field: writes what precedes its body (the left padding, the prefix
+// such as a sign or 0x, `zeroes` leading zeros) and returns the padding still
+// due after the body. With the '0' flag (if `zero_pad` allows it) the padding
+// is zeros placed after the prefix.
+s21_size_t field_open(output* out, const settings* settings, const char* prefix,
+                      s21_size_t prefix_len, s21_size_t zeroes,
+                      s21_size_t body_len, bool zero_pad) {
+  s21_size_t len = prefix_len + zeroes + body_len;
+  s21_size_t width = settings->set_width ? (s21_size_t)settings->width : 0;
+  s21_size_t pad = width > len ? width - len : 0;
 
-  // if value is 0, do not prepend 0x or 0
-  if (value == 0) {
-    settings->sharp = false;
+  if (!settings->left_justify) {
+    if (zero_pad && settings->left_pad_zeroes) {
+      zeroes += pad;
+    } else {
+      out_fill(out, ' ', pad);
+    }
+    pad = 0;
   }
+  out_write(out, prefix, prefix_len);
+  out_fill(out, '0', zeroes);
 
-  while (value != 0) {
-    *ptmp-- = "0123456789abcdef"[value % base];
-    value /= base;
-  }
-  handle_int_precision(&ptmp, settings, tmp + SBUF_SIZE - 2 - ptmp);
-  s21_strncpy(buf, ptmp + 1, SBUF_SIZE);
+  return pad;
 }
 
-void handle_int(char* buf, const settings* settings, va_list ap) {
-  long value;
-  if (settings->short_int) {
-    value = (short)va_arg(ap, int);
-  } else if (settings->long_int) {
-    value = va_arg(ap, long);
+void emit_field(output* out, const settings* settings, const char* prefix,
+                s21_size_t prefix_len, s21_size_t zeroes, const char* body,
+                s21_size_t body_len, bool zero_pad) {
+  s21_size_t pad = field_open(out, settings, prefix, prefix_len, zeroes,
+                              body_len, zero_pad);
+  out_write(out, body, body_len);
+  out_fill(out, ' ', pad);
+}
+
+// zeros needed to bring `digits` digits up to the precision (default 1)
+s21_size_t int_zeroes(const settings* settings, s21_size_t digits) {
+  s21_size_t precision = settings->set_precision ? settings->precision : 1;
+  return precision > digits ? precision - digits : 0;
+}
+
+// The digits go straight to their final place in the destination; only a
+// field that would be truncated is assembled in a local buffer first.
+void emit_integer(output* out, const settings* settings, const char* prefix,
+                  s21_size_t prefix_len, unsigned long value, int base,
+                  const char* table) {
+  s21_size_t n = count_digits(value, base);
+  s21_size_t zeroes = int_zeroes(settings, n);
+  // '#' with %o makes the first digit a zero
+  if (base == 8 && settings->sharp && zeroes == 0 && (value != 0 || n == 0)) {
+    zeroes = 1;
+  }
+
+  // the '0' flag is ignored when a precision is given
+  s21_size_t pad = field_open(out, settings, prefix, prefix_len, zeroes, n,
+                              !settings->set_precision);
+  char* dst = out_direct(out, n);
+  if (dst) {
+    write_digits(dst + n, value, base, table);
   } else {
-    value = va_arg(ap, int);
+    char digits[24];
+    write_digits(digits + n, value, base, table);
+    out_write(out, digits, n);
   }
-  int_to_str(buf, settings, value);
+  out_fill(out, ' ', pad);
 }
 
-void handle_unsigned_int(char* buf, settings* settings, va_list ap, int base) {
-  unsigned long value;
-  if (settings->short_int) {
-    value = (unsigned short)va_arg(ap, unsigned int);
-  } else if (settings->long_int) {
-    value = va_arg(ap, unsigned long);
-  } else {
-    value = va_arg(ap, unsigned int);
+void emit_int(output* out, const settings* settings, long value) {
+  char prefix[1];
+  unsigned long magnitude =
+      value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+  s21_size_t prefix_len = sign_prefix(prefix, settings, value < 0);
+  emit_integer(out, settings, prefix, prefix_len, magnitude, 10, S21_NULL);
+}
+
+// %o, %u, %x, %X and %p (which always has the 0x prefix)
+void emit_unsigned(output* out, const settings* settings, unsigned long value) {
+  const char* table = "0123456789abcdef";
+  const char* prefix = "0x";
+  s21_size_t prefix_len = 0;
+  int base = 16;
+
+  switch (settings->specifier) {
+    case 'o':
+      base = 8;
+      break;
+    case 'u':
+      base = 10;
+      break;
+    case 'X':
+      table = "0123456789ABCDEF";
+      prefix = "0X";
+      prefix_len = settings->sharp && value != 0 ? 2 : 0;
+      break;
+    case 'x':
+      prefix_len = settings->sharp && value != 0 ? 2 : 0;
+      break;
+    case 'p':
+      prefix_len = 2;
+      break;
   }
-  unsigned_int_to_str(buf, settings, value, base);
+
+  emit_integer(out, settings, prefix, prefix_len, value, base, table);
 }
 
 int double_get_precision(const settings* settings) {
@@ -285,323 +525,907 @@ int double_get_precision(const settings* settings) {
   return precision;
 }
 
-int normalize_double(long double* value) {
-  int exp = 0;
-  if (fabsl(*value) > EPSILON) {
-    while (*value > 10) {
-      *value /= 10;
-      exp++;
-    }
-    while (*value < 1) {
-      *value *= 10;
-      exp--;
-    }
-  }
-  return exp;
+char exponent_char(const settings* settings) {
+  return settings->specifier == 'E' || settings->specifier == 'G' ? 'E' : 'e';
 }
 
-void frac_to_str(char** ptmp, const settings* settings, long double value) {
-  int precision = double_get_precision(settings);
-  for (int i = 0; i < precision; i++) {
-    value *= 10;
-    int digit = (int)value;
-    *(*ptmp)++ = digit + '0';
-    value -= digit;
+// inf and nan: no zero padding, upper case for %E, %F and %G
+void emit_nonfinite(output* out, const settings* settings, const char* prefix,
+                    s21_size_t prefix_len, long double value) {
+  char specifier = settings->specifier;
+  bool upper = specifier == 'E' || specifier == 'F' || specifier == 'G';
+  const char* body = upper ? "INF" : "inf";
+  if (isnan(value)) {
+    body = upper ? "NAN" : "nan";
   }
-  **ptmp = 0;
+  emit_field(out, settings, prefix, prefix_len, 0, body, 3, false);
 }
 
-void double_handle_sign(char** ptmp, const settings* settings,
-                        long double* value) {
-  if (signbit(*value)) {
-    *(*ptmp)++ = '-';
-    *value = -*value;
-  } else if (settings->force_sign) {
-    *(*ptmp)++ = '+';
-  } else if (settings->force_space) {
-    *(*ptmp)++ = ' ';
+// Fixed notation: the integer digits, then `precision` digits after the
+// point. Positions past the generated digits are zeros.
+void emit_fixed(output* out, const settings* settings, const char* prefix,
+                s21_size_t prefix_len, const s21_decimal* dec, int precision) {
+  s21_size_t count = dec->count;
+  s21_size_t frac_len = precision;
+  s21_size_t int_len = dec->point > 0 ? dec->point : 1;
+  bool dot = precision > 0 || settings->sharp;
+  s21_size_t pad = field_open(out, settings, prefix, prefix_len, 0,
+                              int_len + dot + frac_len, true);
+
+  if (dec->point > 0) {
+    s21_size_t n = count < int_len ? count : int_len;
+    out_write(out, dec->digits, n);
+    out_fill(out, '0', int_len - n);
+  } else {
+    out_write(out, "0", 1);
   }
+  if (dot) {
+    out_write(out, ".", 1);
+  }
+
+  // zeros up to the first significant digit, the digits, zeros again
+  s21_size_t lead = dec->point < 0 ? (s21_size_t)-dec->point : 0;
+  lead = lead < frac_len ? lead : frac_len;
+  s21_size_t from = dec->point > 0 ? (s21_size_t)dec->point : 0;
+  s21_size_t n = count > from ? count - from : 0;
+  n = n < frac_len - lead ? n : frac_len - lead;
+  out_fill(out, '0', lead);
+  out_write(out, dec->digits + from, n);
+  out_fill(out, '0', frac_len - lead - n);
+  out_fill(out, ' ', pad);
 }
 
-void double_to_str(char* buf, const settings* settings, long double value) {
-  char tmp[SBUF_SIZE];
-  char* ptmp = tmp;
+// Scientific notation: one digit, `precision` more after the point and an
+// exponent of at least two digits.
+void emit_scientific(output* out, const settings* settings,
+                     const char* prefix, s21_size_t prefix_len,
+                     const s21_decimal* dec, int precision) {
+  int exp = dec->count > 0 ? dec->point - 1 : 0;
+  unsigned long exp_abs = exp < 0 ? 0UL - exp : (unsigned long)exp;
+  s21_size_t exp_digits = count_digits(exp_abs, 10);
+  exp_digits = exp_digits < 2 ? 2 : exp_digits;
+  char exponent[8];
+  exponent[0] = exponent_char(settings);
+  exponent[1] = exp < 0 ? '-' : '+';
+  s21_memset(exponent + 2, '0', exp_digits);
+  write_decimal(exponent + 2 + exp_digits, exp_abs);
 
-  double_handle_sign(&ptmp, settings, &value);
+  s21_size_t count = dec->count;
+  s21_size_t frac_len = precision;
+  bool dot = precision > 0 || settings->sharp;
+  s21_size_t pad = field_open(out, settings, prefix, prefix_len, 0,
+                              1 + dot + frac_len + 2 + exp_digits, true);
 
-  int precision = double_get_precision(settings);
-  // add 5 to the right of the last digit (rounding)
-  value += 5 * powl(10, -precision - 1);
+  out_write(out, count > 0 ? dec->digits : "0", 1);
+  if (dot) {
+    out_write(out, ".", 1);
+  }
+  s21_size_t n = count > 1 ? count - 1 : 0;
+  n = n < frac_len ? n : frac_len;
+  out_write(out, dec->digits + 1, n);
+  out_fill(out, '0', frac_len - n);
+  out_write(out, exponent, 2 + exp_digits);
+  out_fill(out, ' ', pad);
+}
 
-  long v = value;
-  struct settings int_settings = {0};
-  int_to_str(ptmp, &int_settings, v);
-  ptmp += s21_strlen(ptmp);
-  value -= (long double)v;
-  if (precision > 0) {
-    *ptmp++ = '.';
+// %g: `precision` significant digits (at least one), in fixed notation when
+// the exponent X satisfies -4 <= X < precision and in scientific otherwise.
+// Without '#' trailing zeros, and then a bare point, are dropped.
+void emit_general(output* out, const settings* settings, const char* prefix,
+                  s21_size_t prefix_len, s21_decimal* dec, int precision) {
+  precision = precision > 0 ? precision : 1;
+  s21_decimal_round(dec, precision);
+  int exp = dec->count > 0 ? dec->point - 1 : 0;
+  int count = dec->count;
+  while (!settings->sharp && count > 0 && dec->digits[count - 1] == '0') {
+    count--;
   }
-  frac_to_str(&ptmp, settings, value);
 
-  *ptmp = 0;
-  s21_strncpy(buf, tmp, SBUF_SIZE);
+  if (exp >= -4 && exp < precision) {
+    int frac = precision - 1 - exp;
+    if (!settings->sharp) {
+      frac = count > dec->point ? count - dec->point : 0;
+    }
+    emit_fixed(out, settings, prefix, prefix_len, dec, frac);
+  } else {
+    int frac = precision - 1;
+    if (!settings->sharp) {
+      frac = count > 1 ? count - 1 : 0;
+    }
+    emit_scientific(out, settings, prefix, prefix_len, dec, frac);
+  }
 }
 
-void double_to_str_e(char* buf, const settings* settings, long double value) {
-  char tmp[SBUF_SIZE];
-  char* ptmp = tmp;
+// The digits are generated exactly from the binary value (see s21_dtoa.c),
+// as many as the conversion needs plus one for rounding. They fit on the
+// stack except for long doubles printed with a huge precision. Returns -1
+// if memory for those runs out.
+int emit_double(output* out, const settings* settings, long double value) {
+  int status = 0;
+  char prefix[1];
+  s21_size_t prefix_len = sign_prefix(prefix, settings, signbit(value));
 
-  double_handle_sign(&ptmp, settings, &value);
+  if (!isfinite(value)) {
+    emit_nonfinite(out, settings, prefix, prefix_len, value);
+  } else {
+    unsigned long mant = 0;
+    int exp2 = s21_float_split(value, settings->long_double, &mant);
+    int precision = double_get_precision(settings);
+    char specifier = settings->specifier;
 
-  int exp = normalize_double(&value);
+    long want = precision > 0 ? precision + 1L : 2;  // %g
+    if (specifier == 'f' || specifier == 'F') {
+      want = s21_decimal_point_bound(mant, exp2) + precision + 1L;
+    } else if (specifier == 'e' || specifier == 'E') {
+      want = precision + 2L;
+    }
+    // the exact expansion may well be shorter than asked for
+    long bound = s21_decimal_digits_bound(mant, exp2);
+    want = want < bound ? want : bound;
 
-  int precision = double_get_precision(settings);
-  if (fabsl(value) > EPSILON) {
-    value += 5 * powl(10, -precision - 1);
-  }
-  exp += normalize_double(&value);
-  int digit = value;
-  *ptmp++ = '0' + digit;
-  value -= digit;
-  if (precision > 0) {
-    *ptmp++ = '.';
+    char local[DIGITS_SIZE];
+    s21_decimal dec = {local, 0, 0, false};
+    if (want > DIGITS_SIZE) {
+      dec.digits = malloc(want);
+    }
+    if (dec.digits == S21_NULL) {
+      status = -1;
+    } else {
+      s21_decimal_exact(&dec, mant, exp2, (int)want);
+      if (specifier == 'f' || specifier == 'F') {
+        s21_decimal_round(&dec, (long)dec.point + precision);
+        emit_fixed(out, settings, prefix, prefix_len, &dec, precision);
+      } else if (specifier == 'e' || specifier == 'E') {
+        s21_decimal_round(&dec, precision + 1L);
+        emit_scientific(out, settings, prefix, prefix_len, &dec, precision);
+      } else {
+        emit_general(out, settings, prefix, prefix_len, &dec, precision);
+      }
+      if (dec.digits != local) {
+        free(dec.digits);
+      }
+    }
   }
 
-  frac_to_str(&ptmp, settings, value);
-  *ptmp++ = 'e';
+  return status;
+}
 
-  struct settings int_settings = {
-      .set_precision = true, .precision = 2, .force_sign = true};
-  int_to_str(ptmp, &int_settings, exp);
-  s21_strncpy(buf, tmp, SBUF_SIZE);
+void emit_str(output* out, const settings* settings, const char* str,
+              s21_size_t len) {
+  emit_field(out, settings, "", 0, 0, str, len, false);
 }
 
-void remove_trailing_zeroes(char* buf, bool scientific) {
-  buf += s21_strlen(buf);
-  if (!scientific) {
-    if (buf[-1] == '0') {
-      while (*--buf == '0') {
-        *buf = 0;
-      }
-      if (*buf == '.') {
-        *buf = 0;
-      }
-    }
+// Bytes in the UTF-8 form of `c`: 0 if it has none (surrogates and values
+// past U+10FFFF).
+int utf8_length(wchar_t c) {
+  unsigned long code = (unsigned long)c;
+  int len = 0;
+  if (code < 0x80) {
+    len = 1;
+  } else if (code < 0x800) {
+    len = 2;
+  } else if (code < 0x10000) {
+    len = code >= 0xD800 && code <= 0xDFFF ? 0 : 3;
+  } else if (code <= 0x10FFFF) {
+    len = 4;
+  }
+  return len;
+}
+
+// Writes the UTF-8 form of `c`, which must have one, and returns its length.
+int utf8_encode(char* dst, wchar_t c) {
+  unsigned long code = (unsigned long)c;
+  int len = utf8_length(c);
+  if (len == 1) {
+    dst[0] = (char)code;
   } else {
-    char exp[10];
-    buf -= 4;
-    s21_strncpy(exp, buf, 5);
-    if (buf[-1] == '0') {
-      while (*--buf == '0') {
-        *buf = 0;
-      }
-      if (*buf == '.') {
-        *buf = 0;
-      }
-      s21_strncpy(buf, exp, 5);
+    // lead byte: `len` ones, a zero, then the top bits of the code point
+    static const unsigned char lead[] = {0, 0, 0xC0, 0xE0, 0xF0};
+    for (int i = len - 1; i > 0; i--) {
+      dst[i] = (char)(0x80 | (code & 0x3F));
+      code >>= 6;
     }
+    dst[0] = (char)(lead[len] | code);
   }
+  return len;
 }
 
-void handle_double_shortest(char* buf, const settings* settings,
-                            long double value) {
-  int precision = double_get_precision(settings);
-  precision += precision == 0 ? 1 : 0;
-  long double tmp = value;
-  int exp = normalize_double(&tmp);
-  if (fabsl(value) > EPSILON) {
-    tmp += 5 * powl(10, -precision - 1);
+// Number of code points at the start of `str` (at most `max`) that are
+// ASCII and not 0. Aligned blocks of WIDE_BLOCK code points are checked at
+// once; like s21_strlen they may read past the end of the string, but never
+// into the next page.
+S21_NO_ASAN s21_size_t wide_ascii_run(const wchar_t* str, s21_size_t max) {
+  s21_size_t i = 0;
+
+  if (sizeof(wchar_t) == 4) {
+    while (i < max && (s21_size_t)(str + i) % (WIDE_BLOCK * 4) != 0 &&
+           str[i] > 0 && str[i] < 0x80) {
+      i++;
+    }
+    // two code points per 64-bit word: a block is plain ASCII if no lane
+    // has bits above 0x7F, and then a lane is 0 exactly when subtracting 1
+    // borrows
+    const wide_word high = 0xFFFFFF80FFFFFF80ULL;
+    const wide_word ones = 0x0000000100000001ULL;
+    const wide_word signs = 0x8000000080000000ULL;
+    while ((s21_size_t)(str + i) % (WIDE_BLOCK * 4) == 0 &&
+           max - i >= WIDE_BLOCK) {
+      const wide_word* w = (const wide_word*)(str + i);
+      wide_word any = 0, zero = 0;
+      for (int k = 0; k < WIDE_BLOCK / 2; k++) {
+        any |= w[k];
+        zero |= w[k] - ones;
+      }
+      zero &= signs;
+      if ((any & high) != 0 || zero != 0) {
+        break;
+      }
+      i += WIDE_BLOCK;
+    }
   }
-  exp += normalize_double(&tmp);
-  // https://stackoverflow.com/questions/54162152/what-precisely-does-the-g-printf-specifier-mean
-  if (exp >= -4 && exp < precision) {
-    struct settings custom_settings = *settings;
-    custom_settings.set_precision = true;
-    custom_settings.precision = precision - 1 - exp;
-    double_to_str(buf, &custom_settings, value);
-    remove_trailing_zeroes(buf, false);
-  } else {
-    struct settings custom_settings = *settings;
-    custom_settings.set_precision = true;
-    custom_settings.precision = precision - 1;
-    double_to_str_e(buf, &custom_settings, value);
-    remove_trailing_zeroes(buf, true);
+  while (i < max && str[i] > 0 && str[i] < 0x80) {
+    i++;
   }
+
+  return i;
 }
 
-void handle_double(char* buf, const settings* settings, va_list ap) {
-  long double value;
-  if (settings->long_double) {
-    value = va_arg(ap, long double);
-  } else {
-    value = va_arg(ap, double);
+// Writes the UTF-8 form of `count` code points, all of which have one, and
+// returns its length.
+s21_size_t utf8_encode_run(char* dst, const wchar_t* str, s21_size_t count) {
+  s21_size_t len = 0;
+  s21_size_t i = 0;
+  while (i < count) {
+    wchar_t any = 0;
+    if (count - i >= WIDE_BLOCK) {
+      for (int k = 0; k < WIDE_BLOCK; k++) {
+        any |= str[i + k];
+      }
+    }
+    if (count - i >= WIDE_BLOCK && any >= 0 && any < 0x80) {
+      for (int k = 0; k < WIDE_BLOCK; k++) {
+        dst[len + k] = (char)str[i + k];
+      }
+      i += WIDE_BLOCK;
+      len += WIDE_BLOCK;
+    } else if (str[i] >= 0 && str[i] < 0x80) {
+      dst[len++] = (char)str[i++];
+    } else {
+      len += utf8_encode(dst + len, str[i++]);
+    }
   }
+  return len;
+}
 
-  switch (settings->specifier) {
-    case 'f':
-      double_to_str(buf, settings, value);
-      break;
-    case 'e':
-    case 'E':
-      double_to_str_e(buf, settings, value);
-      break;
-    case 'g':
-    case 'G':
-      handle_double_shortest(buf, settings, value);
-      break;
+// %lc: UTF-8 whatever the locale; -1 for a value that is not a character
+int emit_wide_char(output* out, const settings* settings, wchar_t c) {
+  char buf[4];
+  int status = -1;
+  if (utf8_length(c) > 0) {
+    emit_str(out, settings, buf, utf8_encode(buf, c));
+    status = 0;
   }
+  return status;
 }
 
-int handle_str(char* buf, const settings* settings, va_list ap) {
+// %ls: UTF-8 whatever the locale. The string is measured first (the
+// precision limits the number of bytes, and a character never gets split),
+// skipping over ASCII a block at a time, then encoded straight into the
+// destination.
+int emit_wide_str(output* out, const settings* settings, const wchar_t* str) {
+  s21_size_t limit = settings->set_precision ? (s21_size_t)settings->precision
+                                             : (s21_size_t)-1;
+  s21_size_t len = 0, count = 0;
   int status = 0;
-  int precision = BUF_SIZE - 2;
-  if (settings->set_precision) {
-    precision = settings->precision;
-  }
-  if (!settings->long_int) {
-    const char* s = va_arg(ap, char*);
-    s21_strncpy(buf, s, precision);
-    buf[precision] = 0;
-  } else {
-    const wchar_t* s = va_arg(ap, wchar_t*);
-    int wstatus = wcstombs(buf, s, precision);
-    if (wstatus == -1) {
+  bool done = false;
+
+  while (!done && status == 0) {
+    s21_size_t ascii = wide_ascii_run(str + count, limit - len);
+    count += ascii;
+    len += ascii;
+    // with the precision used up the array may end right here
+    int n = len == limit || str[count] == 0 ? 0 : utf8_length(str[count]);
+    if (n == 0 && len != limit && str[count] != 0) {
       status = -1;
+    } else if (n == 0 || len + n > limit) {
+      done = true;
+    } else {
+      len += n;
+      count++;
+    }
+  }
+
+  if (status == 0) {
+    s21_size_t width = settings->set_width ? (s21_size_t)settings->width : 0;
+    s21_size_t pad = width > len ? width - len : 0;
+    if (!settings->left_justify) {
+      out_fill(out, ' ', pad);
+    }
+    char* dst = out_direct(out, len);
+    if (dst) {
+      utf8_encode_run(dst, str, count);
+    } else {
+      // the output is cut short or goes to a sink: encode in pieces
+      char buf[WIDE_BLOCK * 4 * 4];
+      for (s21_size_t i = 0; i < count; i += WIDE_BLOCK * 4) {
+        s21_size_t piece = count - i < WIDE_BLOCK * 4 ? count - i
+                                                       : WIDE_BLOCK * 4;
+        out_write(out, buf, utf8_encode_run(buf, str + i, piece));
+      }
+    }
+    if (settings->left_justify) {
+      out_fill(out, ' ', pad);
     }
   }
+
   return status;
 }
 
-void handle_prefix(char* buf, const settings* settings) {
-  if (settings->sharp) {
-    switch (settings->specifier) {
-      case 'o':
-        insert_inplace(buf, "0", 0);
-        break;
-      case 'x':
-      case 'p':
-      case 'X':
-        insert_inplace(buf, "0x", 0);
-        break;
-    }
+long int_arg(const settings* settings, va_list ap) {
+  long value;
+  if (settings->short_int) {
+    value = (short)va_arg(ap, int);
+  } else if (settings->long_int) {
+    value = va_arg(ap, long);
+  } else {
+    value = va_arg(ap, int);
   }
+  return value;
 }
 
-void handle_pointer(char* buf, settings* settings, va_list ap) {
-  struct settings custom_settings = *settings;
-  custom_settings.sharp = true;
-  unsigned long ptr = va_arg(ap, unsigned long);
-  if (ptr == 0) {
-    s21_strncpy(buf, "(nil)", 6);
+unsigned long unsigned_arg(const settings* settings, va_list ap) {
+  unsigned long value;
+  if (settings->short_int) {
+    value = (unsigned short)va_arg(ap, unsigned int);
+  } else if (settings->long_int) {
+    value = va_arg(ap, unsigned long);
   } else {
-    unsigned_int_to_str(buf, settings, ptr, 16);
-    handle_prefix(buf, &custom_settings);
+    value = va_arg(ap, unsigned int);
   }
+  return value;
 }
 
-int arg_to_str(char* buf, settings* settings, va_list ap) {
+int emit_arg(output* out, const settings* settings, va_list ap) {
   int status = 0;
   switch (settings->specifier) {
     case 'c':
-      status = handle_char(buf, settings, ap);
+      if (settings->long_int) {
+        status = emit_wide_char(out, settings, va_arg(ap, int));
+      } else {
+        char c = va_arg(ap, int);
+        emit_str(out, settings, &c, 1);
+      }
       break;
     case 'd':
     case 'i':
-      handle_int(buf, settings, ap);
+      emit_int(out, settings, int_arg(settings, ap));
       break;
     case 'e':
+    case 'E':
     case 'f':
+    case 'F':
     case 'g':
-      handle_double(buf, settings, ap);
-      break;
-    case 'E':
     case 'G':
-      handle_double(buf, settings, ap);
-      to_upper_inplace(buf);
+      if (settings->long_double) {
+        status = emit_double(out, settings, va_arg(ap, long double));
+      } else {
+        status = emit_double(out, settings, va_arg(ap, double));
+      }
       break;
     case 'o':
-      handle_unsigned_int(buf, settings, ap, 8);
-      handle_prefix(buf, settings);
-      break;
-    case 's':
-      status = handle_str(buf, settings, ap);
-      break;
     case 'u':
-      handle_unsigned_int(buf, settings, ap, 10);
-      break;
     case 'x':
-      handle_unsigned_int(buf, settings, ap, 16);
-      handle_prefix(buf, settings);
-      break;
     case 'X':
-      handle_unsigned_int(buf, settings, ap, 16);
-      handle_prefix(buf, settings);
-      to_upper_inplace(buf);
+      emit_unsigned(out, settings, unsigned_arg(settings, ap));
       break;
-    case 'p':
-      handle_pointer(buf, settings, ap);
+    case 's':
+      if (settings->long_int) {
+        status = emit_wide_str(out, settings, va_arg(ap, wchar_t*));
+      } else {
+        const char* str = va_arg(ap, const char*);
+        s21_size_t len = 0;
+        if (str == S21_NULL) {
+          str = "(null)";
+        }
+        // with a precision the string need not be terminated
+        if (settings->set_precision) {
+          while (len < (s21_size_t)settings->precision && str[len]) {
+            len++;
+          }
+        } else {
+          len = s21_strlen(str);
+        }
+        emit_str(out, settings, str, len);
+      }
+      break;
+    case 'p': {
+      unsigned long ptr = (unsigned long)va_arg(ap, void*);
+      if (ptr == 0) {
+        emit_str(out, settings, "(nil)", 5);
+      } else {
+        emit_unsigned(out, settings, ptr);
+      }
       break;
+    }
     case '%':
-      buf[0] = '%';
-      buf[1] = 0;
+      out_write(out, "%", 1);
       break;
   }
   return status;
 }
 
-void copy_with_width(char** str, const char* buf, const settings* settings) {
-  int len = s21_strlen(buf);
-  char c = settings->left_pad_zeroes ? '0' : ' ';
-  int remaining = settings->set_width ? settings->width - len : 0;
-  if (settings->left_justify) {
-    s21_strncpy(*str, buf, len + 1);
-    *str += len;
-    while (remaining-- > 0) {
-      *(*str)++ = c;
+// Hands the staged bytes to the sink. After a failed write the sink is
+// dropped and the rest of the output is only counted.
+void out_flush(output* out) {
+  s21_size_t staged = out->len - out->base;
+  if (staged > 0 && out->sink->write(out->sink->ctx, out->dst, staged) != 0) {
+    out->sink = S21_NULL;
+    out->cap = 0;
+    out->failed = true;
+  }
+  out->base = out->len;
+}
+
+// out_write when the staging buffer cannot take `n` more bytes: it is
+// flushed, and a block larger than the whole buffer goes to the sink as is
+void sink_write(output* out, const char* src, s21_size_t n) {
+  out_flush(out);
+  if (out->sink && n >= out->cap - 1) {
+    if (out->sink->write(out->sink->ctx, src, n) != 0) {
+      out->sink = S21_NULL;
+      out->cap = 0;
+      out->failed = true;
     }
+    out->len += n;
+    out->base = out->len;
   } else {
-    while (remaining-- > 0) {
-      *(*str)++ = c;
+    out_write(out, src, n);
+  }
+}
+
+void out_write(output* out, const char* src, s21_size_t n) {
+  s21_size_t used = out->len - out->base;
+  if (out->sink && n > out->cap - 1 - used) {
+    sink_write(out, src, n);
+  } else {
+    if (used < out->cap) {
+      s21_size_t room = out->cap - 1 - used;
+      s21_memcpy(out->dst + used, src, n < room ? n : room);
     }
-    s21_strncpy(*str, buf, len + 1);
-    *str += len;
+    out->len += n;
   }
-  **str = 0;
 }
 
-int s21_sprintf(char* str, const char* format, ...) {
-  va_list ap;
-  va_start(ap, format);
-  const char* str_start = str;
+void out_fill(output* out, char c, s21_size_t n) {
+  // most fields need no padding at all
+  while (n > 0) {
+    s21_size_t used = out->len - out->base;
+    s21_size_t room = used < out->cap ? out->cap - 1 - used : 0;
+    s21_size_t chunk = n < room ? n : room;
+    if (chunk > 0) {
+      s21_memset(out->dst + used, c, chunk);
+      out->len += chunk;
+      n -= chunk;
+    }
+    if (n > 0 && out->sink) {
+      out_flush(out);
+    } else {
+      out->len += n;
+      n = 0;
+    }
+  }
+}
+
+// Pointer to the next `n` bytes of the destination, which the caller must
+// fill, or S21_NULL (and nothing is counted) if they would not all be stored.
+char* out_direct(output* out, s21_size_t n) {
+  char* dst = S21_NULL;
+  if (out->sink && n > out->cap - 1 - (out->len - out->base)) {
+    out_flush(out);
+  }
+  s21_size_t used = out->len - out->base;
+  if (used < out->cap && out->cap - 1 - used >= n) {
+    dst = out->dst + used;
+    out->len += n;
+  }
+  return dst;
+}
+
+// terminates the stored part of the output
+void out_finish(output* out) {
+  s21_size_t used = out->len - out->base;
+  if (out->cap > 0) {
+    out->dst[used < out->cap ? used : out->cap - 1] = 0;
+  }
+}
+
+// Terminates (or flushes) the output and returns its full length, or -1 on a
+// conversion error, a failed sink write or if the length does not fit in int.
+int out_result(output* out, int err) {
+  if (out->sink) {
+    out_flush(out);
+  }
+  out_finish(out);
+  int ret = out->len;
+  if (err || out->failed || out->len > INT_MAX) {
+    ret = -1;
+  }
+  return ret;
+}
+
+int format_to(output* out, const char* format, va_list ap) {
   int err = 0;
   while (*format && !err) {
     if (*format != '%') {
-      *str++ = *format++;
-      continue;
+      // literal text up to the next conversion goes out as one block
+      const char* literal = format;
+      while (*format && *format != '%') {
+        format++;
+      }
+      out_write(out, literal, format - literal);
     } else {
       format++;
       if (*format == 'n') {
         int* ptr = va_arg(ap, int*);
-        *ptr = str - str_start;
+        *ptr = out->len;
         format++;
         continue;
       }
       settings settings = {0};
-      read_settings(&format, &settings, ap);
-      char buf[BUF_SIZE];
-      int status = arg_to_str(buf, &settings, ap);
-      if (status == 0) {
-        copy_with_width(&str, buf, &settings);
+      read_settings(&format, &settings);
+      read_star_args(&settings, ap);
+      err = emit_arg(out, &settings, ap);
+    }
+  }
+  return out_result(out, err);
+}
+
+int s21_sprintf(char* str, const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int ret = s21_vsprintf(str, format, ap);
+  va_end(ap);
+  return ret;
+}
+
+// Like s21_sprintf, but stores at most `size - 1` characters and always
+// terminates them (if `size > 0`). Returns the length the complete output
+// would have, so `s21_snprintf(S21_NULL, 0, ...)` only measures.
+int s21_snprintf(char* str, s21_size_t size, const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int ret = s21_vsnprintf(str, size, format, ap);
+  va_end(ap);
+  return ret;
+}
+
+int s21_vsprintf(char* str, const char* format, va_list ap) {
+  output out = {.dst = str, .cap = (s21_size_t)-1};
+  return format_to(&out, format, ap);
+}
+
+int s21_vsnprintf(char* str, s21_size_t size, const char* format,
+                  va_list ap) {
+  output out = {.dst = str, .cap = size};
+  return format_to(&out, format, ap);
+}
+
+// Formats through a small staging buffer that is handed to `sink` whenever
+// it fills up and once more at the end, so the output may have any length;
+// text longer than the buffer goes to the sink without being copied.
+// Returns the output length, or -1 on a conversion error or if a sink write
+// failed (the sink gets nothing more after that).
+int s21_sink_printf(const s21_sink* sink, const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int ret = s21_sink_vprintf(sink, format, ap);
+  va_end(ap);
+  return ret;
+}
+
+int s21_sink_vprintf(const s21_sink* sink, const char* format, va_list ap) {
+  char staging[SINK_BUFFER_SIZE + 1];  // and a byte for out_finish
+  output out = {.dst = staging, .cap = sizeof(staging), .sink = sink};
+  return format_to(&out, format, ap);
+}
+
+// Allocates a string of exactly the needed size from the thread's allocator
+// (the heap by default, so it is released with free), formats into it and
+// stores it in *strp. Returns the length, or -1 with *strp set to S21_NULL
+// on a conversion error or when out of memory.
+int s21_asprintf(char** strp, const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int ret = s21_vasprintf(strp, format, ap);
+  va_end(ap);
+  return ret;
+}
+
+int s21_vasprintf(char** strp, const char* format, va_list ap) {
+  char stack[ASPRINTF_STACK_SIZE];
+  const s21_allocator* allocator = s21_thread_allocator();
+  char* str = S21_NULL;
+  va_list again;
+  va_copy(again, ap);
+
+  int len = s21_vsnprintf(stack, sizeof(stack), format, ap);
+  if (len >= 0) {
+    str = s21_allocate(allocator, (s21_size_t)len + 1);
+  }
+  if (str && (s21_size_t)len < sizeof(stack)) {
+    s21_memcpy(str, stack, (s21_size_t)len + 1);
+  } else if (str && s21_vsprintf(str, format, again) != len) {
+    s21_deallocate(allocator, str);
+    str = S21_NULL;
+  }
+  if (str == S21_NULL) {
+    len = -1;
+  }
+
+  va_end(again);
+  *strp = str;
+  return len;
+}
+
+// Writes the shortest decimal form of `value` that reads back as the same
+// double, laid out like %.17g: scientific notation only for exponents below
+// -4 or above 16. `str` needs S21_DTOA_SIZE bytes; returns the length.
+s21_size_t s21_dtoa(char* str, double value) {
+  output out = {.dst = str, .cap = S21_DTOA_SIZE};
+  settings settings = {0};
+  settings.specifier = 'g';
+  char prefix[1];
+  s21_size_t prefix_len = sign_prefix(prefix, &settings, signbit(value));
+
+  if (!isfinite(value)) {
+    emit_nonfinite(&out, &settings, prefix, prefix_len, value);
+  } else {
+    char digits[S21_SHORTEST_DIGITS];
+    s21_decimal dec = {digits, 0, 0, false};
+    s21_decimal_shortest(&dec, value);
+    emit_general(&out, &settings, prefix, prefix_len, &dec,
+                 S21_SHORTEST_DIGITS);
+  }
+  out_finish(&out);
+  return out.len;
+}
+
+// Parses `format` once into literal runs and decoded conversions, so that
+// s21_sprintf_compiled only copies text and converts arguments. The result
+// is never modified and may be shared between threads. It comes from the
+// thread's allocator as one block; S21_NULL if memory runs out.
+s21_format* s21_format_compile(const char* format) {
+  // every conversion starts with '%': this bounds the number of items
+  s21_size_t len = 0;
+  s21_size_t count = 1;
+  for (; format[len]; len++) {
+    count += format[len] == '%';
+  }
+
+  const s21_allocator* allocator = s21_thread_allocator();
+  s21_format* compiled = s21_allocate(
+      allocator, sizeof(s21_format) + count * sizeof(format_item) + len + 1);
+  if (compiled) {
+    char* text = (char*)(compiled->items + count);
+    format_item* item = compiled->items;
+    *item = (format_item){text, 0, {0}};
+
+    while (*format) {
+      if (*format != '%') {
+        const char* literal = format;
+        while (*format && *format != '%') {
+          format++;
+        }
+        s21_memcpy(text, literal, format - literal);
+        text += format - literal;
+        item->literal_len += format - literal;
       } else {
-        err = -1;
+        format++;
+        settings settings = {0};
+        if (*format == 'n') {
+          settings.specifier = 'n';
+          format++;
+        } else {
+          read_settings(&format, &settings);
+        }
+
+        if (settings.specifier == '%') {
+          *text++ = '%';
+          item->literal_len++;
+        } else {
+          item->settings = settings;
+          item++;
+          *item = (format_item){text, 0, {0}};
+        }
       }
     }
+    compiled->allocator = allocator;
+    compiled->count = item - compiled->items + 1;
   }
-  va_end(ap);
-  *str = 0;
-  int ret = str - str_start;
-  if (err) {
-    ret = -1;
+  return compiled;
+}
+
+void s21_format_free(s21_format* format) {
+  if (format) {
+    s21_deallocate(format->allocator, format);
   }
-  return ret;
+}
+
+int format_compiled_to(output* out, const s21_format* format, va_list ap) {
+  int err = 0;
+  for (s21_size_t i = 0; i < format->count && !err; i++) {
+    const format_item* item = &format->items[i];
+    out_write(out, item->literal, item->literal_len);
+    if (item->settings.specifier == 'n') {
+      int* ptr = va_arg(ap, int*);
+      *ptr = out->len;
+    } else if (item->settings.width_arg || item->settings.precision_arg) {
+      settings settings = item->settings;
+      read_star_args(&settings, ap);
+      err = emit_arg(out, &settings, ap);
+    } else if (item->settings.specifier) {
+      err = emit_arg(out, &item->settings, ap);
+    }
+  }
+  return out_result(out, err);
+}
+
+// s21_sprintf with a compiled format and the arguments as a va_list
+int s21_sprintf_compiled(char* str, const s21_format* format, va_list ap) {
+  output out = {.dst = str, .cap = (s21_size_t)-1};
+  return format_compiled_to(&out, format, ap);
+}
+
+int s21_snprintf_compiled(char* str, s21_size_t size, const s21_format* format,
+                          va_list ap) {
+  output out = {.dst = str, .cap = size};
+  return format_compiled_to(&out, format, ap);
+}
+
+int cell_long(output* out, const settings* settings, const s21_column* column,
+              s21_size_t row) {
+  emit_int(out, settings, column->longs[row]);
+  return 0;
+}
+
+int cell_unsigned(output* out, const settings* settings,
+                  const s21_column* column, s21_size_t row) {
+  emit_unsigned(out, settings, (unsigned long)column->longs[row]);
+  return 0;
+}
+
+int cell_char(output* out, const settings* settings, const s21_column* column,
+              s21_size_t row) {
+  char c = column->longs[row];
+  emit_str(out, settings, &c, 1);
+  return 0;
+}
+
+int cell_double(output* out, const settings* settings,
+                const s21_column* column, s21_size_t row) {
+  return emit_double(out, settings, column->doubles[row]);
+}
+
+int cell_string(output* out, const settings* settings,
+                const s21_column* column, s21_size_t row) {
+  const char* str = column->strings[row];
+  s21_size_t limit = settings->set_precision ? (s21_size_t)settings->precision
+                                             : (s21_size_t)-1;
+  s21_size_t len = 0;
+
+  if (str && column->lengths) {
+    len = column->lengths[row] < limit ? column->lengths[row] : limit;
+  } else {
+    if (str == S21_NULL) {
+      str = "(null)";
+    }
+    if (settings->set_precision) {
+      while (len < limit && str[len]) {
+        len++;
+      }
+    } else {
+      len = s21_strlen(str);
+    }
+  }
+  emit_str(out, settings, str, len);
+  return 0;
+}
+
+// Pairs every conversion of `format` with the next column and its kernel.
+// Returns -1 if a conversion has no kernel for batches ('*', %n, %p, wide
+// characters) or its column holds values of another type.
+int bind_cells(row_cell* cells, const s21_format* format,
+               const s21_column* columns) {
+  int status = 0;
+  for (s21_size_t i = 0; i < format->count && status == 0; i++) {
+    const format_item* item = &format->items[i];
+    const settings* settings = &item->settings;
+    int type = S21_COLUMN_LONG;
+    cells[i] = (row_cell){item, S21_NULL, S21_NULL};
+
+    switch (settings->specifier) {
+      case 0:
+        break;
+      case 'd':
+      case 'i':
+        cells[i].emit = cell_long;
+        break;
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':
+        cells[i].emit = cell_unsigned;
+        break;
+      case 'c':
+        cells[i].emit = settings->long_int ? S21_NULL : cell_char;
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+        cells[i].emit = cell_double;
+        type = S21_COLUMN_DOUBLE;
+        break;
+      case 's':
+        cells[i].emit = settings->long_int ? S21_NULL : cell_string;
+        type = S21_COLUMN_STRING;
+        break;
+      default:
+        status = -1;
+    }
+
+    if (settings->specifier && status == 0) {
+      cells[i].column = columns++;
+      if (cells[i].emit == S21_NULL || cells[i].column->type != type ||
+          settings->width_arg || settings->precision_arg) {
+        status = -1;
+      }
+    }
+  }
+  return status;
+}
+
+// Formats rows [first, last) of s21_format_rows into `str`, bounded by
+// `size`: offsets[r] gets the offset of row r from `str` and *len the length
+// of all the rows. offsets[last] is left alone, so ranges that follow each
+// other may be formatted at the same time.
+int s21_format_row_range(char* str, s21_size_t size, const s21_format* format,
+                         const s21_column* columns, s21_size_t first,
+                         s21_size_t last, s21_size_t* offsets,
+                         s21_size_t* len) {
+  output out = {.dst = str, .cap = size};
+  row_cell* cells = s21_allocate(S21_NULL, format->count * sizeof(row_cell));
+  int err = cells ? bind_cells(cells, format, columns) : -1;
+
+  for (s21_size_t row = first; row < last && !err; row++) {
+    offsets[row] = out.len;
+    for (s21_size_t i = 0; i < format->count && !err; i++) {
+      const row_cell* cell = &cells[i];
+      out_write(&out, cell->item->literal, cell->item->literal_len);
+      if (cell->emit) {
+        err = cell->emit(&out, &cell->item->settings, cell->column, row);
+      }
+    }
+  }
+  out_finish(&out);
+  *len = out.len;
+
+  s21_deallocate(S21_NULL, cells);
+  return err ? -1 : 0;
+}
+
+// Formats `rows` rows at once, the i-th conversion of `format` taking its
+// value from columns[i]. The rows go one after another into `str`, bounded
+// by `size` like s21_snprintf, and offsets[r] (rows + 1 entries) receives
+// the offset of row r in the complete output, so offsets[rows] is its
+// length; when that is not below `size` the output was cut short. Returns
+// 0, or -1 if a column does not fit its conversion (see s21_column) or a
+// conversion fails.
+int s21_format_rows(char* str, s21_size_t size, const s21_format* format,
+                    const s21_column* columns, s21_size_t rows,
+                    s21_size_t* offsets) {
+  return s21_format_row_range(str, size, format, columns, 0, rows, offsets,
+                              &offsets[rows]);
 }
@@ -1,20 +1,80 @@
 #include "s21_string.h"
 
+#include <errno.h>
 #include <stdlib.h>
 
+#include "s21_simd.h"
+
+/* Пословное (SWAR) сканирование: строка читается машинными словами,
+выровненными по своему размеру, поэтому чтение никогда не пересекает границу
+страницы. HAS_ZERO(x) не равно нулю тогда и только тогда, когда в слове x есть
+нулевой байт. */
+#if defined(__GNUC__)
+typedef s21_size_t __attribute__((__may_alias__)) s21_word;
+#else
+typedef s21_size_t s21_word;
+#endif
+
+#define WORD_SIZE sizeof(s21_word)
+#define WORD_ONES ((s21_size_t)-1 / 0xFF)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+#define HAS_ZERO(x) ((((x) - WORD_ONES) & ~(x)) & WORD_HIGHS)
+#define IS_WORD_ALIGNED(p) ((s21_size_t)(p) % WORD_SIZE == 0)
+
+/* s21_memchr, s21_memcmp, s21_memcpy, s21_memset, s21_memmove и s21_strlen
+вызываются через таблицу s21_dispatch, которую s21_simd.c при запуске
+заполняет векторными версиями; ниже в этом файле — их переносимые
+реализации. */
 void* s21_memchr(const void* str, int c, s21_size_t n) {
+  return s21_dispatch.memchr(str, c, n);
+}
+
+int s21_memcmp(const void* str1, const void* str2, s21_size_t n) {
+  return s21_dispatch.memcmp(str1, str2, n);
+}
+
+void* s21_memcpy(void* dest, const void* src, s21_size_t n) {
+  return s21_dispatch.memcpy(dest, src, n);
+}
+
+void* s21_memset(void* str, int c, s21_size_t n) {
+  return s21_dispatch.memset(str, c, n);
+}
+
+void* s21_memmove(void* dest, const void* src, s21_size_t n) {
+  return s21_dispatch.memmove(dest, src, n);
+}
+
+s21_size_t s21_strlen(const char* str) { return s21_dispatch.strlen(str); }
+
+void* s21_memchr_scalar(const void* str, int c, s21_size_t n) {
   const unsigned char* s = (const unsigned char*)str;
   unsigned char ch = (unsigned char)c;
-  void* result = S21_NULL;
 
-  for (s21_size_t i = 0; i < n; i++) {
-    if (s[i] == ch) {
-      result = (void*)(s + i);
-      break;
+  // побайтово до границы слова
+  while (n > 0 && !IS_WORD_ALIGNED(s) && *s != ch) {
+    s++;
+    n--;
+  }
+
+  // целыми словами, не выходя за n байт
+  if (n > 0 && *s != ch) {
+    const s21_size_t mask = WORD_ONES * ch;
+    const s21_word* w = (const s21_word*)s;
+    while (n >= WORD_SIZE && !HAS_ZERO(*w ^ mask)) {
+      w++;
+      n -= WORD_SIZE;
     }
+    s = (const unsigned char*)w;
   }
 
-  return result;
+  // хвост или слово, в котором найдено совпадение
+  while (n > 0 && *s != ch) {
+    s++;
+    n--;
+  }
+
+  return n > 0 ? (void*)s : S21_NULL;
 }
 /*
 - <0, если первый отличающийся байт (переинтерпретируемый как unsigned char) в
@@ -24,7 +84,7 @@ void* s21_memchr(const void* str, int c, s21_size_t n) {
 - >0, если первый отличающийся байт в левой части больше соответствующего байта
 в правой части.
 */
-int s21_memcmp(const void* str1, const void* str2, s21_size_t n) {
+int s21_memcmp_scalar(const void* str1, const void* str2, s21_size_t n) {
   const unsigned char* s1 = (const unsigned char*)str1;
   const unsigned char* s2 = (const unsigned char*)str2;
   int result = 0;
@@ -40,7 +100,7 @@ int s21_memcmp(const void* str1, const void* str2, s21_size_t n) {
 }
 
 // TODO: check with passing null
-void* s21_memcpy(void* dest, const void* src, s21_size_t n) {
+void* s21_memcpy_scalar(void* dest, const void* src, s21_size_t n) {
   const unsigned char* s = (const unsigned char*)src;
   unsigned char* d = (unsigned char*)dest;
 
@@ -51,8 +111,26 @@ void* s21_memcpy(void* dest, const void* src, s21_size_t n) {
   return dest;
 }
 
+void* s21_memmove_scalar(void* dest, const void* src, s21_size_t n) {
+  const unsigned char* s = (const unsigned char*)src;
+  unsigned char* d = (unsigned char*)dest;
+
+  // при dest > src с перекрытием копируем с конца
+  if ((s21_size_t)(d - s) >= n) {
+    for (s21_size_t i = 0; i < n; i++) {
+      d[i] = s[i];
+    }
+  } else {
+    for (s21_size_t i = n; i > 0; i--) {
+      d[i - 1] = s[i - 1];
+    }
+  }
+
+  return dest;
+}
+
 // TODO: check with passing null
-void* s21_memset(void* str, int c, s21_size_t n) {
+void* s21_memset_scalar(void* str, int c, s21_size_t n) {
   unsigned char* s = (unsigned char*)str;
 
   for (s21_size_t i = 0; i < n; i++) {
@@ -74,15 +152,29 @@ char* s21_strncat(char* dest, const char* src, s21_size_t n) {
   return dest;
 }
 
-char* s21_strchr(const char* str, int c) {
+S21_NO_ASAN char* s21_strchr(const char* str, int c) {
   const unsigned char ch = (unsigned char)c;
-  int i = 0;
+  const unsigned char* s = (const unsigned char*)str;
 
-  while (str[i] && str[i] != ch) {
-    i++;
+  while (!IS_WORD_ALIGNED(s) && *s && *s != ch) {
+    s++;
   }
 
-  return ch == str[i] ? (char*)(str + i) : S21_NULL;
+  if (IS_WORD_ALIGNED(s)) {
+    const s21_size_t mask = WORD_ONES * ch;
+    const s21_word* w = (const s21_word*)s;
+    // слово без нуля и без искомого символа пропускается целиком
+    while (!HAS_ZERO(*w) && !HAS_ZERO(*w ^ mask)) {
+      w++;
+    }
+    s = (const unsigned char*)w;
+  }
+
+  while (*s && *s != ch) {
+    s++;
+  }
+
+  return ch == *s ? (char*)s : S21_NULL;
 }
 
 int s21_strncmp(const char* str1, const char* str2, s21_size_t n) {
@@ -122,41 +214,126 @@ char* s21_strncpy(char* dest, const char* src, s21_size_t n) {
   return dest;
 }
 
+/* Множество байтов хранится транспонированной битовой таблицей: байт
+b = hhhh llll входит в множество, если в table[(b >> 7) * 16 + llll] выставлен
+бит (hhhh & 7). Так одна и та же таблица годится и для скалярной проверки, и
+для векторного поиска по полубайтам (pshufb) в s21_simd.c. */
+#define CHARSET_INDEX(b) (((b) >> 7) * 16 + ((b)&0x0F))
+#define CHARSET_BIT(b) (1u << (((b) >> 4) & 7))
+
+void s21_charset_init(s21_charset* set, const char* chars) {
+  s21_memset(set->table, 0, sizeof(set->table));
+  for (const unsigned char* c = (const unsigned char*)chars; *c; c++) {
+    set->table[CHARSET_INDEX(*c)] |= CHARSET_BIT(*c);
+  }
+}
+
+int s21_charset_has(const s21_charset* set, int c) {
+  unsigned char b = (unsigned char)c;
+  return (set->table[CHARSET_INDEX(b)] & CHARSET_BIT(b)) != 0;
+}
+
+/* Позиция первого байта строки, который равен '\0' или принадлежность
+которого множеству равна stop_on_member. */
+s21_size_t s21_charset_scan_scalar(const char* str, const s21_charset* set,
+                                   int stop_on_member) {
+  const unsigned char* s = (const unsigned char*)str;
+
+  while (*s && s21_charset_has(set, *s) != stop_on_member) {
+    s++;
+  }
+
+  return (const char*)s - str;
+}
+
+s21_size_t s21_strcspn_set(const char* str, const s21_charset* reject) {
+  return s21_dispatch.charset_scan(str, reject, 1);
+}
+
+s21_size_t s21_strspn_set(const char* str, const s21_charset* accept) {
+  return s21_dispatch.charset_scan(str, accept, 0);
+}
+
+/* То же для первых n байтов без учёта терминатора: '\0' — обычный байт. */
+s21_size_t s21_charset_scan_n_scalar(const char* str, s21_size_t n,
+                                     const s21_charset* set,
+                                     int stop_on_member) {
+  const unsigned char* s = (const unsigned char*)str;
+  s21_size_t i = 0;
+
+  while (i < n && s21_charset_has(set, s[i]) != stop_on_member) {
+    i++;
+  }
+
+  return i;
+}
+
+char* s21_strpbrk_set(const char* str, const s21_charset* accept) {
+  const char* p = str + s21_strcspn_set(str, accept);
+  return *p ? (char*)p : S21_NULL;
+}
+
 /* Длина первой части строки string1 не содержащей никакие символы строки
 string2. Длина строки string1, если ни один из символов строки string2 не входит
 в состав string1. */
 s21_size_t s21_strcspn(const char* str1, const char* str2) {
-  const char* ptr_str1 = str1;
-  char ch_str1;
-  s21_size_t result = 0;
-  int found = 0;
+  s21_charset reject;
+  s21_charset_init(&reject, str2);
+  return s21_strcspn_set(str1, &reject);
+}
 
-  while (!found && (ch_str1 = *ptr_str1++) != '\0') {
-    const char* ptr_str2 = str2;
-    char ch_str2;
-    while ((ch_str2 = *ptr_str2++) != '\0') {
-      if (ch_str1 == ch_str2) {
-        found = 1;
-        break;
-      }
-    }
+// Длина начальной части str1, состоящей только из символов str2
+s21_size_t s21_strspn(const char* str1, const char* str2) {
+  s21_charset accept;
+  s21_charset_init(&accept, str2);
+  return s21_strspn_set(str1, &accept);
+}
+
+S21_NO_ASAN s21_size_t s21_strlen_scalar(const char* str) {
+  const char* s = str;
 
-    if (!found) {
-      result++;
+  while (!IS_WORD_ALIGNED(s) && *s != '\0') {
+    s++;
+  }
+
+  if (IS_WORD_ALIGNED(s)) {
+    const s21_word* w = (const s21_word*)s;
+    while (!HAS_ZERO(*w)) {
+      w++;
     }
+    s = (const char*)w;
   }
 
-  return result;
+  while (*s != '\0') {
+    s++;
+  }
+
+  return s - str;
 }
 
-s21_size_t s21_strlen(const char* str) {
-  s21_size_t len = 0;
+/* Длина строки, но не больше max. Как и s21_strlen_scalar, читает только
+выровненные слова, поэтому не выходит за страницу с терминатором. */
+S21_NO_ASAN s21_size_t s21_strnlen_scalar(const char* str, s21_size_t max) {
+  const char* s = str;
+  const char* end = str + max;
 
-  while (str[len] != '\0') {
-    len++;
+  while (s < end && !IS_WORD_ALIGNED(s) && *s != '\0') {
+    s++;
   }
 
-  return len;
+  if (s < end && IS_WORD_ALIGNED(s)) {
+    const s21_word* w = (const s21_word*)s;
+    while ((const char*)w < end && !HAS_ZERO(*w)) {
+      w++;
+    }
+    s = (const char*)w;
+  }
+
+  while (s < end && *s != '\0') {
+    s++;
+  }
+
+  return (s < end ? s : end) - str;
 }
 
 #if defined(__APPLE__)
@@ -414,34 +591,81 @@ static const char* errorList[] = {
 
 #endif
 
+/* Записывает в buf (size > 0) сообщение для кода вне таблицы: ERROR и
+десятичный код, с обрезкой до size - 1 байт. Возвращает полную длину
+сообщения. */
+static s21_size_t unknown_error(char* buf, s21_size_t size, int errorNumber) {
+  char digits[16];
+  char* d = digits + sizeof(digits);
+  unsigned value = errorNumber < 0 ? 0u - (unsigned)errorNumber
+                                   : (unsigned)errorNumber;
+
+  do {
+    *--d = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  if (errorNumber < 0) {
+    *--d = '-';
+  }
+
+  s21_size_t prefix_len = sizeof(ERROR) - 1;
+  s21_size_t digits_len = digits + sizeof(digits) - d;
+  s21_size_t len = 0;
+  for (s21_size_t i = 0; i < prefix_len + digits_len && len + 1 < size; i++) {
+    buf[len++] = i < prefix_len ? ERROR[i] : d[i - prefix_len];
+  }
+  buf[len] = '\0';
+
+  return prefix_len + digits_len;
+}
+
+/* Сообщения из таблицы возвращаются без копирования и не должны изменяться
+вызывающим. Для неизвестных кодов используется буфер своего потока. */
 char* s21_strerror(int errorNumber) {
-  static char result[512] = {'\0'};
+  static _Thread_local char unknown[64];
+  char* result;
 
   if (errorNumber < 0 || errorNumber > MAX_ERRLIST) {
-    s21_sprintf(result, "Unknown error %d", errorNumber);
+    unknown_error(unknown, sizeof(unknown), errorNumber);
+    result = unknown;
   } else {
-    s21_strncpy(result, errorList[errorNumber], sizeof(result) - 1);
-    result[sizeof(result) - 1] = '\0';
+    result = (char*)errorList[errorNumber];
   }
 
   return result;
 }
 
+/* Реентерабельный вариант (как XSI strerror_r): сообщение копируется в buf.
+Возвращает 0, EINVAL для неизвестного кода (сообщение всё равно
+записывается) или ERANGE, если сообщение пришлось обрезать. */
+int s21_strerror_r(int errorNumber, char* buf, s21_size_t buflen) {
+  int status = 0;
+  s21_size_t len = 0;
+
+  if (buflen == 0) {
+    status = ERANGE;
+  } else if (errorNumber < 0 || errorNumber > MAX_ERRLIST) {
+    len = unknown_error(buf, buflen, errorNumber);
+    status = EINVAL;
+  } else {
+    len = s21_strlen(errorList[errorNumber]);
+    s21_size_t copy = len < buflen ? len : buflen - 1;
+    s21_memcpy(buf, errorList[errorNumber], copy);
+    buf[copy] = '\0';
+  }
+  if (len >= buflen) {
+    status = ERANGE;
+  }
+
+  return status;
+}
+
 /* Возвращает указатель на первре вхождение в строку str1
 любого символа из str2 или NULL */
 char* s21_strpbrk(const char* str1, const char* str2) {
-  s21_size_t i;
-  int result = __INT_MAX__;
-  for (i = 0; i < s21_strlen(str2); i++) {
-    const char* ptr = s21_strchr(str1, str2[i]);
-    if (ptr != S21_NULL) {
-      int offset = ptr - str1;
-      if (offset < result) {
-        result = offset;
-      }
-    }
-  }
-  return result != __INT_MAX__ ? (char*)str1 + result : S21_NULL;
+  s21_charset accept;
+  s21_charset_init(&accept, str2);
+  return s21_strpbrk_set(str1, &accept);
 }
 
 /* Выполняет поиск последнего вхождения символа c
@@ -461,200 +685,777 @@ char* s21_strrchr(const char* str, int c) {
   return result;
 }
 
-char* s21_strstr(const char* haystack, const char* needle) {
-  char ch_needle = *needle++;
-  s21_size_t needle_len = s21_strlen(needle);
-
-  if (ch_needle == '\0') return (char*)haystack;
+/* Есть ли в стоге байты [0, need). Если длина стога известна не полностью
+(bounded == 0), она дочитывается порциями по мере продвижения поиска, так что
+ранняя находка не требует просмотра всего стога. */
+static int hay_available(const unsigned char* hay, s21_size_t* hay_len,
+                         int bounded, s21_size_t need) {
+  if (!bounded && need > *hay_len) {
+    *hay_len += s21_dispatch.strnlen((const char*)hay + *hay_len,
+                                     need - *hay_len + 256);
+  }
+  return need <= *hay_len;
+}
 
-  do {
-    char ch_haystack;
+/* Критическая факторизация иглы (Crochemore-Perrin): позиция разбиения
+needle = u·v, где v — больший из максимальных суффиксов для прямого и
+обратного порядка байтов, и период v в *period. */
+static s21_size_t critical_factorization(const unsigned char* needle,
+                                         s21_size_t m, s21_size_t* period) {
+  s21_size_t split = 0;
 
-    do {
-      ch_haystack = *haystack++;
-      if (ch_haystack == '\0') return (char*)0;
-    } while (ch_haystack != ch_needle);
-  } while (s21_strncmp(haystack, needle, needle_len) != 0);
+  if (m < 3) {
+    *period = 1;
+    split = m - 1;
+  } else {
+    s21_size_t max_suffix[2], p[2];
+    for (int reverse = 0; reverse < 2; reverse++) {
+      s21_size_t suffix = (s21_size_t)-1, j = 0, k = 1;
+      p[reverse] = 1;
+      while (j + k < m) {
+        unsigned char a = needle[j + k];
+        unsigned char b = needle[suffix + k];
+        if (reverse ? a > b : a < b) {
+          j += k;
+          k = 1;
+          p[reverse] = j - suffix;
+        } else if (a == b) {
+          if (k != p[reverse]) {
+            k++;
+          } else {
+            j += p[reverse];
+            k = 1;
+          }
+        } else {
+          suffix = j++;
+          k = p[reverse] = 1;
+        }
+      }
+      max_suffix[reverse] = suffix;
+    }
+    // (s21_size_t)-1 + 1 == 0: пустой максимальный префикс
+    int use_reverse = max_suffix[0] + 1 < max_suffix[1] + 1;
+    *period = p[use_reverse];
+    split = max_suffix[use_reverse] + 1;
+  }
 
-  return (char*)(haystack - 1);
+  return split;
 }
 
-char* s21_strtok(char* str, const char* delim) {
-  char* spanp;  // для перебора символов delim
-  int ch_str, ch_delim;
-  char* tok;  // текущий токен
-  static char* last;  // позиция последнего найденного токена
-
-  if (str == S21_NULL && (str = last) == S21_NULL) {
-    return S21_NULL;
-  }
-
-  // пропуск разделителей в начале строки
-  /* Цикл пропускает любые начальные символы из строки str, которые являются
-   * разделителями, указанными в delim. */
-  int flag = 1;
-  while (flag) {
-    flag = 0;
-    ch_str = *str++;
-    for (spanp = (char*)delim; (ch_delim = *spanp++) != 0;) {
-      if (ch_str == ch_delim) {
-        flag = 1;
-        break;
+/* Двусторонний поиск (Two-Way): линейное время в худшем случае и O(1)
+дополнительной памяти. Правая часть иглы сравнивается слева направо, левая —
+справа налево; для периодичной иглы запоминается уже совпавший префикс. */
+static const unsigned char* two_way_search(const unsigned char* hay,
+                                           s21_size_t hay_len, int bounded,
+                                           const unsigned char* needle,
+                                           s21_size_t m) {
+  const unsigned char* result = S21_NULL;
+  s21_size_t period;
+  s21_size_t suffix = critical_factorization(needle, m, &period);
+  s21_size_t j = 0;
+
+  if (s21_memcmp(needle, needle + period, suffix) == 0) {
+    s21_size_t memory = 0;
+    while (!result && hay_available(hay, &hay_len, bounded, j + m)) {
+      s21_size_t i = suffix > memory ? suffix : memory;
+      while (i < m && needle[i] == hay[i + j]) {
+        i++;
+      }
+      if (i >= m) {
+        i = suffix - 1;
+        while (memory < i + 1 && needle[i] == hay[i + j]) {
+          i--;
+        }
+        if (i + 1 < memory + 1) {
+          result = hay + j;
+        }
+        j += period;
+        memory = m - period;
+      } else {
+        j += i - suffix + 1;
+        memory = 0;
+      }
+    }
+  } else {
+    period = (suffix > m - suffix ? suffix : m - suffix) + 1;
+    while (!result && hay_available(hay, &hay_len, bounded, j + m)) {
+      s21_size_t i = suffix;
+      while (i < m && needle[i] == hay[i + j]) {
+        i++;
+      }
+      if (i >= m) {
+        i = suffix - 1;
+        while (i != (s21_size_t)-1 && needle[i] == hay[i + j]) {
+          i--;
+        }
+        if (i == (s21_size_t)-1) {
+          result = hay + j;
+        }
+        j += period;
+      } else {
+        j += i - suffix + 1;
       }
     }
   }
 
-  // проверка окончания строки
-  if (ch_str == 0) {
-    last = S21_NULL;
-    return S21_NULL;
-  }
+  return result;
+}
 
-  // установка начала токена
-  tok = str - 1;
+/* Короткая игла (не длиннее слова) целиком помещается в машинное слово;
+окно стога сдвигается по байту и сравнивается с ней одной операцией. */
+static const char* short_needle_search(const char* haystack,
+                                       const char* needle, s21_size_t m) {
+  const unsigned char* h = (const unsigned char*)haystack;
+  const unsigned char* n = (const unsigned char*)needle;
+  const s21_size_t mask =
+      m == WORD_SIZE ? (s21_size_t)-1 : ((s21_size_t)1 << (8 * m)) - 1;
+  s21_size_t needle_word = 0, window = 0, filled = 0;
+  const char* result = S21_NULL;
+
+  for (s21_size_t i = 0; i < m; i++) {
+    needle_word = needle_word << 8 | n[i];
+  }
 
-  // поиск конца токена
-  while (1) {
-    ch_str = *str++;
-    spanp = (char*)delim;
-    do {
-      if ((ch_delim = *spanp++) == ch_str) {
-        if (ch_str == 0)
-          str = S21_NULL;
-        else
-          str[-1] = 0;
-        last = str;
-        return tok;
-      }
-    } while (ch_delim != 0);
+  for (; !result && *h; h++) {
+    window = (window << 8 | *h) & mask;
+    if (++filled >= m && window == needle_word) {
+      result = (const char*)h - m + 1;
+    }
   }
+
+  return result;
 }
 
-void* s21_to_upper(const char* str) {
-  char* upper_str = S21_NULL;
+char* s21_strstr(const char* haystack, const char* needle) {
+  const char* result = S21_NULL;
+  s21_size_t m = s21_strnlen_scalar(needle, WORD_SIZE + 1);
 
-  if (str != S21_NULL) {
-    s21_size_t len = s21_strlen(str);
+  if (m == 0) {
+    result = haystack;
+  } else {
+    // до первого вхождения первого символа иглы
+    haystack = s21_strchr(haystack, *needle);
+    if (haystack == S21_NULL || m == 1) {
+      result = haystack;
+    } else if (m <= WORD_SIZE) {
+      result = short_needle_search(haystack, needle, m);
+    } else {
+      m += s21_strlen(needle + m);
+      result = (const char*)two_way_search(
+          (const unsigned char*)haystack, 0, 0, (const unsigned char*)needle,
+          m);
+    }
+  }
 
-    upper_str = calloc(s21_strlen(str) + 1, sizeof(char));
+  return (char*)result;
+}
 
-    // Преобразование строки в верхний регистр
-    for (s21_size_t i = 0; i < len; i++) {
-      if (str[i] >= 'a' && str[i] <= 'z') {
-        upper_str[i] = str[i] - 32;
-      } else {
-        upper_str[i] = str[i];
+/* Приблизительная частота байтов в текстах и логах (больше — чаще). По ней
+s21_search_prepare выбирает самый редкий байт иглы. */
+static const unsigned char byte_rank[256] = {
+      0,  10,  10,  10,  10,  10,  10,  10,  10, 120, 120,  10,  10, 120,  10,  10,
+     10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,
+    255,  75, 135,  65,  55,  65,  70, 120, 110, 110,  70,  90, 150, 150, 170, 145,
+    180, 178, 176, 174, 172, 170, 168, 166, 164, 162, 150, 100,  80, 135,  80,  75,
+     60, 136, 102, 118, 120, 140, 112, 108, 124, 132,  94,  98, 122, 114, 130, 134,
+    110,  92, 126, 128, 138, 116, 100, 106,  96, 104,  90,  95,  55,  95,  40, 140,
+     40, 242, 174, 206, 210, 250, 194, 186, 218, 234, 158, 166, 214, 198, 230, 238,
+    190, 154, 222, 226, 246, 202, 170, 182, 162, 178, 150,  85,  55,  85,  40,  60,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+};
+
+// ниже этой частоты редкий байт ищется через s21_memchr
+#define RARE_BYTE_RANK 100
+
+int s21_search_prepare(s21_search* search, const char* needle) {
+  int status = -1;
+
+  if (search != S21_NULL && needle != S21_NULL) {
+    const unsigned char* n = (const unsigned char*)needle;
+    s21_size_t m = s21_strlen(needle);
+
+    search->needle = needle;
+    search->len = m;
+    search->rare_index = 0;
+    for (s21_size_t i = 1; i < m; i++) {
+      if (byte_rank[n[i]] < byte_rank[n[search->rare_index]]) {
+        search->rare_index = i;
       }
     }
+    search->use_prefilter =
+        m < 4 || byte_rank[n[search->rare_index]] < RARE_BYTE_RANK;
 
-    // Завершение строки нулевым символом
-    upper_str[len] = '\0';
+    // таблица сдвигов Хорспула по последнему байту окна
+    for (int c = 0; c < 256; c++) {
+      search->shift[c] = m;
+    }
+    for (s21_size_t i = 0; i + 1 < m; i++) {
+      search->shift[n[i]] = m - 1 - i;
+    }
+    status = 0;
   }
 
-  return upper_str;
+  return status;
 }
 
-void* s21_to_lower(const char* str) {
-  char* lower_str = S21_NULL;
+// кандидаты — вхождения редкого байта на своей позиции в игле
+static const unsigned char* prefilter_search(const s21_search* search,
+                                             const unsigned char* h,
+                                             s21_size_t n) {
+  const unsigned char* needle = (const unsigned char*)search->needle;
+  const s21_size_t m = search->len;
+  const s21_size_t ri = search->rare_index;
+  const unsigned char* last = h + n - m + ri;
+  const unsigned char* p = h + ri;
+  const unsigned char* result = S21_NULL;
+
+  while (!result && p <= last &&
+         (p = s21_memchr(p, needle[ri], last - p + 1)) != S21_NULL) {
+    if (s21_memcmp(p - ri, needle, m) == 0) {
+      result = p - ri;
+    }
+    p++;
+  }
 
-  if (str != S21_NULL) {
-    s21_size_t len = s21_strlen(str);
+  return result;
+}
 
-    lower_str = calloc(s21_strlen(str) + 1, sizeof(char));
+static const unsigned char* horspool_search(const s21_search* search,
+                                            const unsigned char* h,
+                                            s21_size_t n) {
+  const unsigned char* needle = (const unsigned char*)search->needle;
+  const s21_size_t m = search->len;
+  const s21_size_t ri = search->rare_index;
+  const unsigned char* result = S21_NULL;
+
+  for (s21_size_t j = 0; !result && j <= n - m;
+       j += search->shift[h[j + m - 1]]) {
+    if (h[j + m - 1] == needle[m - 1] && h[j + ri] == needle[ri] &&
+        s21_memcmp(h + j, needle, m - 1) == 0) {
+      result = h + j;
+    }
+  }
 
-    for (s21_size_t i = 0; i < len; i++) {
-      if (str[i] >= 'A' && str[i] <= 'Z') {
-        lower_str[i] = str[i] + 32;
-      } else {
-        lower_str[i] = str[i];
+  return result;
+}
+
+// первое вхождение непустой иглы в n байтов h
+static const unsigned char* search_bytes(const s21_search* search,
+                                         const unsigned char* h,
+                                         s21_size_t n) {
+  const unsigned char* result = S21_NULL;
+
+  if (search->len <= n) {
+    result = search->use_prefilter ? prefilter_search(search, h, n)
+                                   : horspool_search(search, h, n);
+  }
+
+  return result;
+}
+
+// порции, которыми s21_search_exec дочитывает стог: первая и наибольшая
+#define SEARCH_CHUNK 4096
+#define SEARCH_MAX_CHUNK (1 << 20)
+
+/* Конец стога ищется порциями по ходу поиска (как в hay_available): окна,
+целиком лежащие в прочитанной части, проверяются сразу, так что находка у
+начала длинной строки не требует её полного прохода. Порции растут вдвое:
+на длинной строке без находки перезапусков поиска O(log n). */
+char* s21_search_exec(const s21_search* search, const char* haystack) {
+  const unsigned char* h = (const unsigned char*)haystack;
+  const unsigned char* result = S21_NULL;
+  const s21_size_t m = search->len;
+
+  if (m == 0) {
+    result = h;
+  } else {
+    s21_size_t chunk = m < SEARCH_CHUNK ? SEARCH_CHUNK : m;
+    s21_size_t start = 0;  // первое ещё не проверенное окно
+    s21_size_t known = 0;  // прочитанная часть стога, без нуля
+    int end = 0;
+    while (result == S21_NULL && !end) {
+      s21_size_t got = s21_dispatch.strnlen(haystack + known, chunk);
+      end = got < chunk;
+      known += got;
+      if (known - start >= m) {
+        result = search_bytes(search, h + start, known - start);
+        start = known - m + 1;
+      }
+      if (chunk < SEARCH_MAX_CHUNK) {
+        chunk *= 2;
       }
     }
   }
 
-  return lower_str;
+  return (char*)result;
 }
 
-void* s21_insert(const char* src, const char* str, s21_size_t start_index) {
-  char* res = S21_NULL;
-  s21_size_t src_len = (src == S21_NULL) ? 0 : s21_strlen(src);
-  s21_size_t str_len = (str == S21_NULL) ? 0 : s21_strlen(str);
-  s21_size_t total_len = src_len + str_len;
+/* Поиск в первых n байтах haystack, длина которых уже известна: нулевые
+байты — обычные символы, как у memmem. */
+char* s21_search_exec_n(const s21_search* search, const char* haystack,
+                        s21_size_t n) {
+  const unsigned char* h = (const unsigned char*)haystack;
+  return (char*)(search->len == 0 ? h : search_bytes(search, h, n));
+}
+
+// позиция, с которой s21_strtok и s21_strtok_set продолжают разбор
+static char* strtok_last = S21_NULL;
+
+static char* tokenize(char* str, const s21_charset* delim, char** last) {
+  char* tok = S21_NULL;
 
-  if (start_index <= src_len) {
-    res = (char*)calloc(src_len + str_len + 1, sizeof(char));
+  if (str == S21_NULL) {
+    str = *last;
   }
-  if (res) {
-    for (s21_size_t i = 0; i < total_len; i++) {
-      if (i < start_index) {
-        res[i] = src[i];
-      } else if (i < str_len + start_index) {
-        res[i] = str[i - start_index];
+
+  if (str != S21_NULL) {
+    // пропуск разделителей в начале строки
+    str += s21_strspn_set(str, delim);
+    if (*str == '\0') {
+      *last = S21_NULL;
+    } else {
+      tok = str;
+      // поиск конца токена
+      str += s21_strcspn_set(str, delim);
+      if (*str == '\0') {
+        *last = S21_NULL;
       } else {
-        res[i] = src[i - str_len];
+        *str = '\0';
+        *last = str + 1;
       }
     }
   }
-  return res;
+
+  return tok;
+}
+
+char* s21_strtok_set(char* str, const s21_charset* delim) {
+  return tokenize(str, delim, &strtok_last);
 }
 
-// Функция, которая проверяет, начинается ли строка с определенной подстроки
-int start_with(const char* str, const char* substr, size_t start) {
-  int res = 0;
-  int size = s21_strlen(substr);
-  for (int i = 0; i < size; i++) {
-    if (str[start] == substr[i]) res = 1;
+char* s21_strtok(char* str, const char* delim) {
+  s21_charset set;
+  s21_charset_init(&set, delim);
+  return tokenize(str, &set, &strtok_last);
+}
+
+/* Реентерабельный s21_strtok: позиция разбора хранится в *saveptr у
+вызывающего. */
+char* s21_strtok_r(char* str, const char* delim, char** saveptr) {
+  s21_charset set;
+  s21_charset_init(&set, delim);
+  return tokenize(str, &set, saveptr);
+}
+
+void s21_tokenizer_init(s21_tokenizer* tokenizer, const char* input,
+                        s21_size_t len, const char* delim) {
+  s21_charset set;
+  s21_charset_init(&set, delim);
+  s21_tokenizer_init_set(tokenizer, input, len, &set);
+}
+
+void s21_tokenizer_init_set(s21_tokenizer* tokenizer, const char* input,
+                            s21_size_t len, const s21_charset* delim) {
+  tokenizer->pos = input;
+  tokenizer->end = input + len;
+  tokenizer->delim = *delim;
+}
+
+/* Следующий токен как пара (указатель, длина) внутри исходного буфера.
+Буфер не изменяется и может не заканчиваться '\0'. Возвращает 0, когда
+токены закончились. */
+int s21_tokenizer_next(s21_tokenizer* tokenizer, const char** token,
+                       s21_size_t* len) {
+  int found = 0;
+  s21_size_t rest = tokenizer->end - tokenizer->pos;
+  s21_size_t skip =
+      s21_dispatch.charset_scan_n(tokenizer->pos, rest, &tokenizer->delim, 0);
+
+  tokenizer->pos += skip;
+  rest -= skip;
+  if (rest > 0) {
+    *len = s21_dispatch.charset_scan_n(tokenizer->pos, rest, &tokenizer->delim,
+                                       1);
+    *token = tokenizer->pos;
+    tokenizer->pos += *len;
+    found = 1;
   }
-  return res;
+
+  return found;
 }
 
-// Функция, которая проверяет, заканчивается ли строка определенной подстрокой
-int end_with(const char* str, const char* substr, size_t end) {
-  int res = 0;
-  end--;
-  int size = s21_strlen(substr);
-  for (int i = 0; i < size; i++) {
-    if (str[end] == substr[i]) res = 1;
+/* Смена регистра ASCII-букв в n байтах src с записью в dst (dst == src
+допустимо). Слово за словом: к младшим 7 битам каждого байта прибавляются
+константы, после которых старший бит байта показывает, что байт не меньше
+первой буквы и не больше последней; байты с установленным старшим битом
+(не ASCII) исключаются, а у подходящих переключается бит 0x20. */
+void s21_case_map_scalar(char* dst, const char* src, s21_size_t n, int upper) {
+  const unsigned char first = upper ? 'a' : 'A';
+  const s21_size_t from_first = WORD_ONES * (0x80 - first);
+  const s21_size_t after_last = WORD_ONES * (0x80 - first - 26);
+  s21_size_t i = 0;
+
+  // пословно — только если src и dst выровнены одинаково (всегда при dst ==
+  // src)
+  if ((s21_size_t)(dst - src) % WORD_SIZE == 0) {
+    for (; i < n && !IS_WORD_ALIGNED(src + i); i++) {
+      unsigned char c = (unsigned char)src[i];
+      dst[i] = (char)((unsigned)(c - first) < 26 ? c ^ 0x20 : c);
+    }
+    for (; i + WORD_SIZE <= n; i += WORD_SIZE) {
+      s21_size_t w = *(const s21_word*)(src + i);
+      s21_size_t low = w & ~WORD_HIGHS;
+      s21_size_t letters =
+          (low + from_first) & ~(low + after_last) & ~w & WORD_HIGHS;
+      *(s21_word*)(dst + i) = w ^ (letters >> 2);
+    }
   }
-  return res;
+
+  for (; i < n; i++) {
+    unsigned char c = (unsigned char)src[i];
+    dst[i] = (char)((unsigned)(c - first) < 26 ? c ^ 0x20 : c);
+  }
+}
+
+static char* case_copy(s21_sv sv, int upper,
+                       const s21_allocator* allocator) {
+  char* result = s21_allocate(allocator, sv.len + 1);
+
+  if (result) {
+    s21_dispatch.case_map(result, sv.ptr, sv.len, upper);
+    result[sv.len] = '\0';
+  }
+
+  return result;
 }
 
-// Функция, которая обрезает указанные символы из начала и конца строки
+static char* case_inplace(char* str, int upper) {
+  if (str != S21_NULL) {
+    s21_dispatch.case_map(str, str, s21_strlen(str), upper);
+  }
+  return str;
+}
+
+static s21_size_t case_into(char* dst, s21_size_t cap, const char* str,
+                            int upper) {
+  s21_size_t len = s21_strlen(str);
+
+  if (cap > 0) {
+    s21_size_t n = len < cap ? len : cap - 1;
+    s21_dispatch.case_map(dst, str, n, upper);
+    dst[n] = '\0';
+  }
+
+  return len;
+}
+
+/* Копия строки в верхнем регистре или S21_NULL. Меняются только
+ASCII-буквы. Память выделяет распределитель потока (по умолчанию — куча,
+результат освобождается через free); варианты *_with принимают
+распределитель явно (S21_NULL — распределитель потока). */
+void* s21_to_upper(const char* str) { return s21_to_upper_with(str, S21_NULL); }
+
+void* s21_to_lower(const char* str) { return s21_to_lower_with(str, S21_NULL); }
+
+void* s21_to_upper_with(const char* str, const s21_allocator* allocator) {
+  return str ? case_copy(s21_sv_from(str), 1, allocator) : S21_NULL;
+}
+
+void* s21_to_lower_with(const char* str, const s21_allocator* allocator) {
+  return str ? case_copy(s21_sv_from(str), 0, allocator) : S21_NULL;
+}
+
+// Меняют регистр на месте и возвращают str
+char* s21_to_upper_inplace(char* str) { return case_inplace(str, 1); }
+
+char* s21_to_lower_inplace(char* str) { return case_inplace(str, 0); }
+
+/* Пишут в dst (cap байт) результат, обрезанный до cap - 1 символов, и всегда
+завершают его нулём, если cap > 0. Возвращают длину str: результат обрезан,
+если она не меньше cap. */
+s21_size_t s21_to_upper_into(char* dst, s21_size_t cap, const char* str) {
+  return case_into(dst, cap, str, 1);
+}
+
+s21_size_t s21_to_lower_into(char* dst, s21_size_t cap, const char* str) {
+  return case_into(dst, cap, str, 0);
+}
+
+static char* insert_copy(s21_sv src, s21_sv str, s21_size_t start_index,
+                         const s21_allocator* allocator);
+
+/* Новая строка: src со вставкой str перед позицией start_index, или
+S21_NULL, если start_index больше длины src. Память — как у s21_to_upper.
+Для серии вставок в один документ — s21_text. */
+void* s21_insert(const char* src, const char* str, s21_size_t start_index) {
+  return s21_insert_with(src, str, start_index, S21_NULL);
+}
+
+void* s21_insert_with(const char* src, const char* str, s21_size_t start_index,
+                      const s21_allocator* allocator) {
+  return insert_copy(s21_sv_from(src), s21_sv_from(str), start_index,
+                     allocator);
+}
+
+/* Границы строки без ведущих и замыкающих символов из trim_set: возвращает
+указатель на первый оставшийся символ, а в *end — на позицию за последним.
+Ничего не копирует; для строки только из таких символов begin == end. */
+const char* s21_trim_view(const char* src, const s21_charset* trim_set,
+                          const char** end) {
+  const char* begin = S21_NULL;
+  const char* last = S21_NULL;
+
+  if (src) {
+    begin = src + s21_strspn_set(src, trim_set);
+    last = begin + s21_strlen(begin);
+    while (last > begin && s21_charset_has(trim_set, *(last - 1))) {
+      last--;
+    }
+  }
+  if (end) {
+    *end = last;
+  }
+
+  return begin;
+}
+
+/* Копия строки без ведущих и замыкающих символов из trim_chars (память —
+как у s21_to_upper). Если trim_chars пуста или S21_NULL, обрезаются пробелы,
+табуляции и переносы строк. */
 void* s21_trim(const char* src, const char* trim_chars) {
+  return s21_trim_with(src, trim_chars, S21_NULL);
+}
+
+void* s21_trim_with(const char* src, const char* trim_chars,
+                    const s21_allocator* allocator) {
   char* newstr = S21_NULL;
 
-  // Проверка на NULL входной строки
   if (src) {
-    // Проверка на NULL или пустую строку символов для обрезки
-    if (trim_chars && trim_chars[0]) {
-      size_t src_len = s21_strlen(src);
+    s21_charset trim_set;
+    s21_charset_init(&trim_set, trim_chars && trim_chars[0] ? trim_chars
+                                                            : "\t\n ");
+    const char* end;
+    const char* begin = s21_trim_view(src, &trim_set, &end);
+
+    s21_size_t len = end - begin;
+    newstr = s21_allocate(allocator, len + 1);
+    if (newstr) {
+      s21_memcpy(newstr, begin, len);
+      newstr[len] = '\0';
+    }
+  }
 
-      // Выделение памяти под новую строку
-      newstr = (char*)calloc(src_len + 1, sizeof(char));
+  return newstr;
+}
 
-      // Поиск начала и конца подстроки для обрезки
-      size_t start = 0, end = src_len;
-      while (start_with(src, trim_chars, start)) {
-        start++;
-      }
-      if (start != end) {
-        while (end_with(src, trim_chars, end)) {
-          end--;
-        }
-      } else {
-        newstr[0] = '\0';
-      }
+/* UTF-8. Проверка и подсчёт символов вызываются через s21_dispatch:
+векторные версии в s21_simd.c, ниже — переносимые. Обе читают ровно n
+байтов; ASCII пропускается словами, как в s21_strlen_scalar. */
+
+s21_size_t s21_utf8_validate(const char* str, s21_size_t n) {
+  return s21_dispatch.utf8_validate(str, n);
+}
 
-      // Копирование символов из оригинальной строки в новую строку без
-      // обрезанных символов
-      for (size_t i = 0; start < end; i++, start++) {
-        newstr[i] = src[start];
+s21_size_t s21_utf8_len(const char* str, s21_size_t n) {
+  return s21_dispatch.utf8_len(str, n);
+}
+
+/* Длина правильной последовательности UTF-8 в начале s (не длиннее n
+байтов) или 0: ни лишних (overlong) форм, ни суррогатов, ни значений
+больше U+10FFFF. */
+static int utf8_sequence(const unsigned char* s, s21_size_t n) {
+  int len = 0;
+  // допустимые значения второго байта
+  unsigned char low = 0x80, high = 0xBF;
+
+  if (s[0] < 0x80) {
+    len = 1;
+  } else if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+    len = 2;
+  } else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+    len = 3;
+    low = s[0] == 0xE0 ? 0xA0 : low;
+    high = s[0] == 0xED ? 0x9F : high;
+  } else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+    len = 4;
+    low = s[0] == 0xF0 ? 0x90 : low;
+    high = s[0] == 0xF4 ? 0x8F : high;
+  }
+
+  if (len > 1 && ((s21_size_t)len > n || s[1] < low || s[1] > high)) {
+    len = 0;
+  }
+  for (int i = 2; i < len; i++) {
+    if ((s[i] & 0xC0) != 0x80) {
+      len = 0;
+    }
+  }
+
+  return len;
+}
+
+/* Смещение начала первой неправильной (или оборванной в конце)
+последовательности в n байтах str; n, если весь текст — правильный UTF-8. */
+s21_size_t s21_utf8_validate_scalar(const char* str, s21_size_t n) {
+  const unsigned char* s = (const unsigned char*)str;
+  s21_size_t i = 0;
+  int len = 1;
+
+  while (i < n && len > 0) {
+    if (s[i] < 0x80 && IS_WORD_ALIGNED(s + i)) {
+      while (n - i >= WORD_SIZE && !(*(const s21_word*)(s + i) & WORD_HIGHS)) {
+        i += WORD_SIZE;
       }
+    }
+    if (i < n) {
+      len = utf8_sequence(s + i, n - i);
+      i += len;
+    }
+  }
+
+  return i;
+}
+
+/* Число символов: байты, не являющиеся продолжением (10xxxxxx). В слове
+продолжения — байты со старшим битом 1 и следующим 0; их число складывает
+умножение на WORD_ONES в старшем байте. */
+s21_size_t s21_utf8_len_scalar(const char* str, s21_size_t n) {
+  const unsigned char* s = (const unsigned char*)str;
+  s21_size_t count = 0;
+  s21_size_t i = 0;
+
+  for (; i < n && !IS_WORD_ALIGNED(s + i); i++) {
+    count += (s[i] & 0xC0) != 0x80;
+  }
+  for (; n - i >= WORD_SIZE; i += WORD_SIZE) {
+    s21_size_t w = *(const s21_word*)(s + i);
+    s21_size_t continuations = w & ~(w << 1) & WORD_HIGHS;
+    count += WORD_SIZE -
+             ((continuations >> 7) * WORD_ONES >> (WORD_SIZE - 1) * 8);
+  }
+  for (; i < n; i++) {
+    count += (s[i] & 0xC0) != 0x80;
+  }
+
+  return count;
+}
+
+/* Наибольшая длина не больше limit, на которой правильный UTF-8 из n
+байтов str можно обрезать, не разрывая символ (например, для %.Ns). */
+s21_size_t s21_utf8_truncate(const char* str, s21_size_t n, s21_size_t limit) {
+  s21_size_t len = n;
+
+  if (n > limit) {
+    const unsigned char* s = (const unsigned char*)str;
+    len = limit;
+    // символ длиннее 4 байтов не бывает: отступаем не больше чем на 3
+    while (len > 0 && limit - len < 3 && (s[len] & 0xC0) == 0x80) {
+      len--;
+    }
+  }
+
+  return len;
+}
+
+/* Представления строк (s21_sv): указатель и длина. Функции ниже не ищут
+терминатор, поэтому работают и с частью буфера, и с данными, содержащими
+нулевые байты. ptr может быть S21_NULL только при len == 0. */
+s21_sv s21_sv_from(const char* str) {
+  s21_sv sv = {str, str ? s21_strlen(str) : 0};
+  return sv;
+}
+
+const char* s21_sv_chr(s21_sv sv, int c) {
+  return s21_memchr(sv.ptr, c, sv.len);
+}
+
+const char* s21_sv_rchr(s21_sv sv, int c) {
+  const char* result = S21_NULL;
+  unsigned char ch = (unsigned char)c;
+
+  for (s21_size_t i = sv.len; !result && i > 0; i--) {
+    if ((unsigned char)sv.ptr[i - 1] == ch) {
+      result = sv.ptr + i - 1;
+    }
+  }
+
+  return result;
+}
+
+/* Первое вхождение needle в hay: до первого байта иглы — через s21_memchr,
+дальше — двусторонний поиск с известной длиной стога. */
+const char* s21_sv_str(s21_sv hay, s21_sv needle) {
+  const char* result = S21_NULL;
+
+  if (needle.len == 0) {
+    result = hay.ptr;
+  } else if (needle.len <= hay.len) {
+    const char* first = s21_memchr(hay.ptr, *needle.ptr, hay.len);
+    if (first == S21_NULL || needle.len == 1) {
+      result = first;
     } else {
-      // Если символы для обрезки не указаны, то обрезаем по умолчанию пробелы,
-      // табуляции и переносы строк
-      newstr = s21_trim(src, "\t\n ");
+      s21_size_t rest = hay.len - (first - hay.ptr);
+      result = (const char*)two_way_search(
+          (const unsigned char*)first, rest, 1,
+          (const unsigned char*)needle.ptr, needle.len);
     }
   }
 
-  return newstr;
-}
\ No newline at end of file
+  return result;
+}
+
+s21_size_t s21_sv_cspn(s21_sv sv, const s21_charset* reject) {
+  return s21_dispatch.charset_scan_n(sv.ptr, sv.len, reject, 1);
+}
+
+s21_size_t s21_sv_spn(s21_sv sv, const s21_charset* accept) {
+  return s21_dispatch.charset_scan_n(sv.ptr, sv.len, accept, 0);
+}
+
+// часть sv без ведущих и замыкающих байтов из trim_set
+s21_sv s21_sv_trim(s21_sv sv, const s21_charset* trim_set) {
+  s21_size_t skip = s21_sv_spn(sv, trim_set);
+  sv.ptr += skip;
+  sv.len -= skip;
+  while (sv.len > 0 && s21_charset_has(trim_set, sv.ptr[sv.len - 1])) {
+    sv.len--;
+  }
+  return sv;
+}
+
+// Копии sv с заменой регистра, завершённые нулём (память — как у s21_to_upper)
+void* s21_sv_to_upper(s21_sv sv) { return case_copy(sv, 1, S21_NULL); }
+
+void* s21_sv_to_lower(s21_sv sv) { return case_copy(sv, 0, S21_NULL); }
+
+/* Новая строка, завершённая нулём (память — как у s21_to_upper): src со
+вставкой str перед позицией start_index, или S21_NULL, если start_index больше
+src.len. */
+void* s21_sv_insert(s21_sv src, s21_sv str, s21_size_t start_index) {
+  return insert_copy(src, str, start_index, S21_NULL);
+}
+
+static char* insert_copy(s21_sv src, s21_sv str, s21_size_t start_index,
+                         const s21_allocator* allocator) {
+  char* res = S21_NULL;
+
+  if (start_index <= src.len) {
+    res = s21_allocate(allocator, src.len + str.len + 1);
+  }
+  if (res) {
+    s21_memcpy(res, src.ptr, start_index);
+    s21_memcpy(res + start_index, str.ptr, str.len);
+    s21_memcpy(res + start_index + str.len, src.ptr + start_index,
+               src.len - start_index);
+    res[src.len + str.len] = '\0';
+  }
+
+  return res;
+}
@@ -1,29 +1,252 @@
 #ifndef S21_STRING_H
 #define S21_STRING_H
 
+#include <stdarg.h>
+
 #define S21_NULL 0
 
+/* Размер буфера для s21_dtoa: самая длинная запись вроде
+"-2.2250738585072014e-308" и завершающий ноль. */
+#define S21_DTOA_SIZE 25
+
 typedef unsigned long s21_size_t;
 
+/* Игла, подготовленная для многократного поиска (s21_search_prepare).
+Хранит указатель на needle, поэтому строка должна жить дольше объекта. После
+подготовки объект только читается и может использоваться из нескольких
+потоков одновременно. */
+typedef struct s21_search {
+  const char* needle;
+  s21_size_t len;
+  s21_size_t rare_index;  // позиция самого редкого байта иглы
+  int use_prefilter;      // искать кандидатов по редкому байту
+  s21_size_t shift[256];  // сдвиги Хорспула
+} s21_search;
+
+/* Множество байтов (s21_charset_init) для функций семейства strcspn:
+строится один раз и проверяет принадлежность байта за O(1). */
+typedef struct s21_charset {
+  unsigned char table[32];
+} s21_charset;
+
+/* Неизменяющий разбор буфера на токены (s21_tokenizer_init): состояние
+целиком у вызывающего, токены — указатели в исходный буфер. */
+typedef struct s21_tokenizer {
+  const char* pos;
+  const char* end;
+  s21_charset delim;
+} s21_tokenizer;
+
+/* Автомат поиска сразу нескольких шаблонов (s21_multisearch_build). Память
+берётся у распределителя потока на момент построения. */
+typedef struct s21_multisearch s21_multisearch;
+
+// Совпадение: номер шаблона в исходном массиве и смещение его начала
+typedef struct s21_match {
+  s21_size_t pattern;
+  s21_size_t offset;
+} s21_match;
+
+typedef int (*s21_match_callback)(const s21_match* match, void* context);
+
+/* Представление строки: указатель и длина, без завершающего нуля
+(s21_sv_from строит его по C-строке). Не владеет данными. */
+typedef struct s21_sv {
+  const char* ptr;
+  s21_size_t len;
+} s21_sv;
+
+/* Распределитель памяти для функций, возвращающих новые строки: alloc и free
+получают ctx первым аргументом; free может быть S21_NULL (память
+освобождается целиком, как у арены). */
+typedef struct s21_allocator {
+  void* (*alloc)(void* ctx, s21_size_t size);
+  void (*free)(void* ctx, void* ptr);
+  void* ctx;
+} s21_allocator;
+
+/* Арена (s21_arena_init): выделение сдвигом указателя, освобождение всего
+сразу через s21_arena_reset. Поля — внутреннее состояние. Распределитель
+арены ссылается на её структуру: копия арены не должна использоваться через
+указатель, полученный от s21_arena_allocator до копирования. */
+typedef struct s21_arena {
+  s21_allocator allocator;
+  struct s21_arena_block* block;
+  char* pos;
+  char* end;
+  s21_size_t block_size;
+} s21_arena;
+
+/* Изменяемый текст для серии вставок и удалений (s21_text_init): буфер с
+разрывом в месте последней правки. Поля — внутреннее состояние; буфер
+выделяется распределителем потока, запомненным при s21_text_init. */
+typedef struct s21_text {
+  const s21_allocator* allocator;
+  char* data;
+  s21_size_t capacity;
+  s21_size_t gap_start;
+  s21_size_t gap_end;
+} s21_text;
+
+/* Строка, собираемая по частям (s21_strbuf_init): длина и ёмкость хранятся,
+буфер растёт вдвое. data — C-строка длины len или S21_NULL, пока ничего не
+добавлено; s21_strbuf_cstr всегда даёт строку. Буфер выделяется
+распределителем потока, запомненным при s21_strbuf_init. */
+typedef struct s21_strbuf {
+  const s21_allocator* allocator;
+  char* data;
+  s21_size_t len;
+  s21_size_t capacity;
+} s21_strbuf;
+
+/* Строка формата, разобранная заранее (s21_format_compile): куски текста и
+готовые описания преобразований. Не меняется после создания, поэтому одну
+и ту же можно использовать из нескольких потоков. */
+typedef struct s21_format s21_format;
+
+/* Столбец значений для s21_format_rows: по одному на каждое преобразование
+формата, по значению на строку таблицы. Числа — long (%d %i %u %o %x %X %c)
+или double (%f %F %e %E %g %G), строки — %s, с длинами в lengths или
+завершённые нулём, если lengths == S21_NULL. Модификаторы длины не
+учитываются. */
+#define S21_COLUMN_LONG 1
+#define S21_COLUMN_DOUBLE 2
+#define S21_COLUMN_STRING 3
+
+typedef struct s21_column {
+  int type;
+  const long* longs;
+  const double* doubles;
+  const char* const* strings;
+  const s21_size_t* lengths;
+} s21_column;
+
+/* Приёмник вывода s21_sink_printf: write получает очередной кусок (ctx —
+первым аргументом) и возвращает 0 или не 0, чтобы прервать вывод. */
+typedef struct s21_sink {
+  int (*write)(void* ctx, const char* data, s21_size_t n);
+  void* ctx;
+} s21_sink;
+
 void* s21_memchr(const void* str, int c, s21_size_t n);
 int s21_memcmp(const void* str1, const void* str2, s21_size_t n);
 void* s21_memcpy(void* dest, const void* src, s21_size_t n);
 void* s21_memset(void* str, int c, s21_size_t n);
+void* s21_memmove(void* dest, const void* src, s21_size_t n);
 char* s21_strncat(char* dest, const char* src, s21_size_t n);
 s21_size_t s21_strlen(const char* str);
 char* s21_strchr(const char* str, int c);
 int s21_strncmp(const char* str1, const char* str2, s21_size_t n);
 char* s21_strncpy(char* dest, const char* src, s21_size_t n);
 s21_size_t s21_strcspn(const char* str1, const char* str2);
+s21_size_t s21_strspn(const char* str1, const char* str2);
+void s21_charset_init(s21_charset* set, const char* chars);
+int s21_charset_has(const s21_charset* set, int c);
+s21_size_t s21_strcspn_set(const char* str, const s21_charset* reject);
+s21_size_t s21_strspn_set(const char* str, const s21_charset* accept);
+char* s21_strpbrk_set(const char* str, const s21_charset* accept);
+char* s21_strtok_set(char* str, const s21_charset* delim);
 char* s21_strerror(int errnum);
+int s21_strerror_r(int errnum, char* buf, s21_size_t buflen);
 char* s21_strpbrk(const char* str1, const char* str2);
 char* s21_strrchr(const char* str, int c);
 char* s21_strstr(const char* haystack, const char* needle);
+int s21_search_prepare(s21_search* search, const char* needle);
+char* s21_search_exec(const s21_search* search, const char* haystack);
+char* s21_search_exec_n(const s21_search* search, const char* haystack,
+                        s21_size_t n);
+s21_multisearch* s21_multisearch_build(const char* const* patterns,
+                                       s21_size_t count);
+void s21_multisearch_free(s21_multisearch* ms);
+s21_size_t s21_multisearch_scan(const s21_multisearch* ms, const char* text,
+                                s21_match_callback callback, void* context);
+s21_size_t s21_multisearch_find(const s21_multisearch* ms, const char* text,
+                                s21_match* matches, s21_size_t capacity);
 char* s21_strtok(char* str, const char* delim);
+char* s21_strtok_r(char* str, const char* delim, char** saveptr);
+void s21_tokenizer_init(s21_tokenizer* tokenizer, const char* input,
+                        s21_size_t len, const char* delim);
+void s21_tokenizer_init_set(s21_tokenizer* tokenizer, const char* input,
+                            s21_size_t len, const s21_charset* delim);
+int s21_tokenizer_next(s21_tokenizer* tokenizer, const char** token,
+                       s21_size_t* len);
 void* s21_to_upper(const char* str);
 void* s21_to_lower(const char* str);
+void* s21_to_upper_with(const char* str, const s21_allocator* allocator);
+void* s21_to_lower_with(const char* str, const s21_allocator* allocator);
+char* s21_to_upper_inplace(char* str);
+char* s21_to_lower_inplace(char* str);
+s21_size_t s21_to_upper_into(char* dst, s21_size_t cap, const char* str);
+s21_size_t s21_to_lower_into(char* dst, s21_size_t cap, const char* str);
 void* s21_insert(const char* src, const char* str, s21_size_t start_index);
+void* s21_insert_with(const char* src, const char* str, s21_size_t start_index,
+                      const s21_allocator* allocator);
+int s21_text_init(s21_text* text, const char* initial);
+void s21_text_free(s21_text* text);
+s21_size_t s21_text_length(const s21_text* text);
+int s21_text_insert(s21_text* text, s21_size_t pos, const char* str,
+                    s21_size_t len);
+s21_size_t s21_text_delete(s21_text* text, s21_size_t pos, s21_size_t count);
+const char* s21_text_flatten(s21_text* text);
+void s21_strbuf_init(s21_strbuf* buf);
+void s21_strbuf_free(s21_strbuf* buf);
+int s21_strbuf_reserve(s21_strbuf* buf, s21_size_t extra);
+int s21_strbuf_append(s21_strbuf* buf, const char* str);
+int s21_strbuf_append_n(s21_strbuf* buf, const char* str, s21_size_t n);
+int s21_strbuf_append_char(s21_strbuf* buf, char c);
+int s21_strbuf_appendf(s21_strbuf* buf, const char* format, ...);
+int s21_strbuf_vappendf(s21_strbuf* buf, const char* format, va_list ap);
+const char* s21_strbuf_cstr(const s21_strbuf* buf);
+char* s21_strbuf_detach(s21_strbuf* buf);
+s21_size_t s21_utf8_validate(const char* str, s21_size_t n);
+s21_size_t s21_utf8_len(const char* str, s21_size_t n);
+s21_size_t s21_utf8_truncate(const char* str, s21_size_t n, s21_size_t limit);
+s21_sv s21_sv_from(const char* str);
+const char* s21_sv_chr(s21_sv sv, int c);
+const char* s21_sv_rchr(s21_sv sv, int c);
+const char* s21_sv_str(s21_sv hay, s21_sv needle);
+s21_size_t s21_sv_cspn(s21_sv sv, const s21_charset* reject);
+s21_size_t s21_sv_spn(s21_sv sv, const s21_charset* accept);
+s21_sv s21_sv_trim(s21_sv sv, const s21_charset* trim_set);
+void* s21_sv_to_upper(s21_sv sv);
+void* s21_sv_to_lower(s21_sv sv);
+void* s21_sv_insert(s21_sv src, s21_sv str, s21_size_t start_index);
 void* s21_trim(const char* src, const char* trim_chars);
+void* s21_trim_with(const char* src, const char* trim_chars,
+                    const s21_allocator* allocator);
+const char* s21_trim_view(const char* src, const s21_charset* trim_set,
+                          const char** end);
 int s21_sprintf(char* str, const char* format, ...);
+int s21_snprintf(char* str, s21_size_t size, const char* format, ...);
+int s21_vsprintf(char* str, const char* format, va_list ap);
+int s21_vsnprintf(char* str, s21_size_t size, const char* format,
+                  va_list ap);
+int s21_sink_printf(const s21_sink* sink, const char* format, ...);
+int s21_sink_vprintf(const s21_sink* sink, const char* format, va_list ap);
+int s21_asprintf(char** strp, const char* format, ...);
+int s21_vasprintf(char** strp, const char* format, va_list ap);
+s21_size_t s21_dtoa(char* str, double value);
+s21_format* s21_format_compile(const char* format);
+void s21_format_free(s21_format* format);
+int s21_sprintf_compiled(char* str, const s21_format* format, va_list ap);
+int s21_snprintf_compiled(char* str, s21_size_t size, const s21_format* format,
+                          va_list ap);
+int s21_format_rows(char* str, s21_size_t size, const s21_format* format,
+                    const s21_column* columns, s21_size_t rows,
+                    s21_size_t* offsets);
+int s21_format_rows_parallel(char* str, s21_size_t size,
+                             const s21_format* format,
+                             const s21_column* columns, s21_size_t rows,
+                             s21_size_t* offsets, int threads);
+const s21_allocator* s21_default_allocator(void);
+const s21_allocator* s21_thread_allocator(void);
+const s21_allocator* s21_set_thread_allocator(const s21_allocator* allocator);
+void* s21_allocate(const s21_allocator* allocator, s21_size_t size);
+void s21_deallocate(const s21_allocator* allocator, void* ptr);
+void s21_arena_init(s21_arena* arena, s21_size_t block_size);
+void* s21_arena_alloc(s21_arena* arena, s21_size_t size);
+void s21_arena_reset(s21_arena* arena);
+void s21_arena_destroy(s21_arena* arena);
+const s21_allocator* s21_arena_allocator(s21_arena* arena);
 
 #endif
\ No newline at end of file
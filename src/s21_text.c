@@ -0,0 +1,318 @@
+#include <stdarg.h>
+
+#include "s21_string.h"
+
+/* Изменяемый текст на буфере с разрывом: символы лежат в data[0, gap_start)
+и data[gap_end, capacity), а разрыв между ними — свободное место. Правка
+сначала переносит разрыв в позицию правки (копируются только символы между
+старой и новой позицией), после чего вставка пишет прямо в разрыв, а
+удаление расширяет его. При серии правок в одном месте каждая стоит
+O(длина вставки); буфер растёт вдвое, так что рост амортизированно линеен.
+Разрыв никогда не бывает пустым: в s21_text_flatten в нём помещается
+завершающий ноль. */
+
+#define TEXT_MIN_CAPACITY 64
+
+s21_size_t s21_text_length(const s21_text* text) {
+  return text->capacity - (text->gap_end - text->gap_start);
+}
+
+// переносит разрыв так, чтобы он начинался в позиции pos
+static void move_gap(s21_text* text, s21_size_t pos) {
+  if (pos < text->gap_start) {
+    s21_size_t n = text->gap_start - pos;
+    s21_memmove(text->data + text->gap_end - n, text->data + pos, n);
+    text->gap_start -= n;
+    text->gap_end -= n;
+  } else if (pos > text->gap_start) {
+    s21_size_t n = pos - text->gap_start;
+    s21_memmove(text->data + text->gap_start, text->data + text->gap_end, n);
+    text->gap_start += n;
+    text->gap_end += n;
+  }
+}
+
+// расширяет буфер так, чтобы в разрыве было больше need байтов
+static int reserve_gap(s21_text* text, s21_size_t need) {
+  int status = 0;
+  s21_size_t gap = text->gap_end - text->gap_start;
+
+  if (gap <= need) {
+    s21_size_t length = s21_text_length(text);
+    s21_size_t capacity = text->capacity * 2;
+    if (capacity < length + need + 1) {
+      capacity = length + need + 1;
+    }
+    if (capacity < TEXT_MIN_CAPACITY) {
+      capacity = TEXT_MIN_CAPACITY;
+    }
+
+    char* data = s21_allocate(text->allocator, capacity);
+    if (data == S21_NULL) {
+      status = -1;
+    } else {
+      // часть после разрыва переезжает в конец нового буфера
+      s21_size_t tail = text->capacity - text->gap_end;
+      if (text->data) {
+        s21_memcpy(data, text->data, text->gap_start);
+        s21_memcpy(data + capacity - tail, text->data + text->gap_end, tail);
+        s21_deallocate(text->allocator, text->data);
+      }
+      text->data = data;
+      text->gap_end = capacity - tail;
+      text->capacity = capacity;
+    }
+  }
+
+  return status;
+}
+
+/* Создаёт текст с копией initial (S21_NULL — пустой текст). Память берётся
+у распределителя потока на момент создания. Возвращает 0 или -1, если не
+хватило памяти. */
+int s21_text_init(s21_text* text, const char* initial) {
+  text->allocator = s21_thread_allocator();
+  text->data = S21_NULL;
+  text->capacity = 0;
+  text->gap_start = 0;
+  text->gap_end = 0;
+
+  int status = 0;
+  if (initial) {
+    status = s21_text_insert(text, 0, initial, s21_strlen(initial));
+  } else {
+    status = reserve_gap(text, 0);
+  }
+
+  return status;
+}
+
+void s21_text_free(s21_text* text) {
+  s21_deallocate(text->allocator, text->data);
+  text->data = S21_NULL;
+  text->capacity = 0;
+  text->gap_start = 0;
+  text->gap_end = 0;
+}
+
+// позиция в тексте байта data[at]; байты разрыва относятся к его началу
+static s21_size_t text_position(const s21_text* text, s21_size_t at) {
+  if (at >= text->gap_end) {
+    at -= text->gap_end - text->gap_start;
+  } else if (at > text->gap_start) {
+    at = text->gap_start;
+  }
+  return at;
+}
+
+/* Вставляет len байтов str перед позицией pos. str может указывать в сам
+текст (например, в результат s21_text_flatten): такой источник запоминается
+позицией в тексте, потому что рост буфера и перенос разрыва двигают его
+байты. Возвращает 0 или -1, если pos больше длины текста, источник из текста
+выходит за его конец или не хватило памяти (текст не меняется). */
+int s21_text_insert(s21_text* text, s21_size_t pos, const char* str,
+                    s21_size_t len) {
+  int status = -1;
+  s21_size_t length = s21_text_length(text);
+  int inside = text->data != S21_NULL && str >= text->data &&
+               str < text->data + text->capacity;
+  s21_size_t src = inside ? text_position(text, str - text->data) : 0;
+
+  if (pos <= length && (!inside || len <= length - src) &&
+      reserve_gap(text, len) == 0) {
+    move_gap(text, pos);
+    char* dst = text->data + text->gap_start;
+    if (inside) {
+      // часть источника до pos осталась перед разрывом, остальное — после
+      s21_size_t head = src < pos ? pos - src : 0;
+      head = head < len ? head : len;
+      s21_memcpy(dst, text->data + src, head);
+      if (head < len) {
+        s21_memcpy(dst + head, text->data + text->gap_end + (src + head - pos),
+                   len - head);
+      }
+    } else {
+      s21_memcpy(dst, str, len);
+    }
+    text->gap_start += len;
+    status = 0;
+  }
+
+  return status;
+}
+
+/* Удаляет до count символов начиная с pos (не дальше конца текста).
+Возвращает число удалённых символов. */
+s21_size_t s21_text_delete(s21_text* text, s21_size_t pos, s21_size_t count) {
+  s21_size_t length = s21_text_length(text);
+  s21_size_t deleted = 0;
+
+  if (pos < length) {
+    deleted = length - pos < count ? length - pos : count;
+    move_gap(text, pos);
+    text->gap_end += deleted;
+  }
+
+  return deleted;
+}
+
+/* Собирает текст в одну C-строку внутри объекта (разрыв уходит в конец) и
+возвращает указатель на неё. Указатель действителен до следующей правки. */
+const char* s21_text_flatten(s21_text* text) {
+  move_gap(text, s21_text_length(text));
+  text->data[text->gap_start] = '\0';
+  return text->data;
+}
+
+/* Построитель строки: в отличие от повторных s21_strncat, длина не
+пересчитывается, а ёмкость растёт вдвое, так что сборка строки длины n
+стоит O(n) копирований и O(log n) перевыделений. Если data не S21_NULL, то
+data[len] == '\0' и capacity > len. */
+
+#define STRBUF_MIN_CAPACITY 64
+
+// пустой построитель с прежним распределителем
+static void strbuf_clear(s21_strbuf* buf) {
+  buf->data = S21_NULL;
+  buf->len = 0;
+  buf->capacity = 0;
+}
+
+/* Память берётся у распределителя потока на момент вызова и возвращается
+ему же, даже если распределитель потока потом сменится. */
+void s21_strbuf_init(s21_strbuf* buf) {
+  buf->allocator = s21_thread_allocator();
+  strbuf_clear(buf);
+}
+
+void s21_strbuf_free(s21_strbuf* buf) {
+  s21_deallocate(buf->allocator, buf->data);
+  strbuf_clear(buf);
+}
+
+/* Как s21_strbuf_reserve, но прежний буфер при росте не освобождается, а
+возвращается в *old (иначе *old == S21_NULL): источник копирования может
+лежать в нём самом. */
+static int strbuf_grow(s21_strbuf* buf, s21_size_t extra, char** old) {
+  int status = 0;
+  *old = S21_NULL;
+
+  if (extra >= (s21_size_t)-1 - buf->len) {
+    status = -1;
+  } else if (buf->data == S21_NULL || buf->capacity - buf->len <= extra) {
+    s21_size_t capacity = buf->capacity * 2;
+    if (capacity < buf->len + extra + 1) {
+      capacity = buf->len + extra + 1;
+    }
+    if (capacity < STRBUF_MIN_CAPACITY) {
+      capacity = STRBUF_MIN_CAPACITY;
+    }
+
+    char* data = s21_allocate(buf->allocator, capacity);
+    if (data == S21_NULL) {
+      status = -1;
+    } else {
+      if (buf->data) {
+        s21_memcpy(data, buf->data, buf->len);
+      }
+      data[buf->len] = '\0';
+      *old = buf->data;
+      buf->data = data;
+      buf->capacity = capacity;
+    }
+  }
+
+  return status;
+}
+
+/* Обеспечивает место ещё для extra байтов (и завершающего нуля). Возвращает
+0 или -1, если не хватило памяти (содержимое не меняется). */
+int s21_strbuf_reserve(s21_strbuf* buf, s21_size_t extra) {
+  char* old = S21_NULL;
+  int status = strbuf_grow(buf, extra, &old);
+  s21_deallocate(buf->allocator, old);
+  return status;
+}
+
+// str может указывать в сам построитель: старый буфер живёт до копирования
+int s21_strbuf_append_n(s21_strbuf* buf, const char* str, s21_size_t n) {
+  char* old = S21_NULL;
+  int status = strbuf_grow(buf, n, &old);
+
+  if (status == 0) {
+    s21_memcpy(buf->data + buf->len, str, n);
+    buf->len += n;
+    buf->data[buf->len] = '\0';
+  }
+  s21_deallocate(buf->allocator, old);
+
+  return status;
+}
+
+int s21_strbuf_append(s21_strbuf* buf, const char* str) {
+  return s21_strbuf_append_n(buf, str, s21_strlen(str));
+}
+
+int s21_strbuf_append_char(s21_strbuf* buf, char c) {
+  int status = s21_strbuf_reserve(buf, 1);
+
+  if (status == 0) {
+    buf->data[buf->len++] = c;
+    buf->data[buf->len] = '\0';
+  }
+
+  return status;
+}
+
+int s21_strbuf_appendf(s21_strbuf* buf, const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int status = s21_strbuf_vappendf(buf, format, ap);
+  va_end(ap);
+  return status;
+}
+
+/* Форматирует прямо в свободную часть буфера. Если результат не поместился,
+буфер расширяется до точного размера и форматирование повторяется. Аргументы
+%s могут указывать в сам построитель: вывод пишется с data[len + 1], чтобы
+нуль в data[len] не затирался, затем сдвигается на байт, а прежний буфер
+освобождается только после второго форматирования. */
+int s21_strbuf_vappendf(s21_strbuf* buf, const char* format, va_list ap) {
+  int status = -1;
+  char* old = S21_NULL;
+  va_list again;
+  va_copy(again, ap);
+
+  if (s21_strbuf_reserve(buf, 1) == 0) {
+    s21_size_t spare = buf->capacity - buf->len - 1;
+    int n = s21_vsnprintf(buf->data + buf->len + 1, spare, format, ap);
+    if (n >= 0 && (s21_size_t)n < spare) {
+      status = 0;
+    } else if (n >= 0 && strbuf_grow(buf, (s21_size_t)n + 1, &old) == 0 &&
+               s21_vsprintf(buf->data + buf->len + 1, format, again) == n) {
+      status = 0;
+    }
+    if (status == 0) {
+      s21_memmove(buf->data + buf->len, buf->data + buf->len + 1, n);
+      buf->len += n;
+    }
+    buf->data[buf->len] = '\0';
+    s21_deallocate(buf->allocator, old);
+  }
+
+  va_end(again);
+  return status;
+}
+
+const char* s21_strbuf_cstr(const s21_strbuf* buf) {
+  return buf->data ? buf->data : "";
+}
+
+/* Отдаёт строку вызывающему (S21_NULL, если ничего не добавлено) и оставляет
+построитель пустым. Строка выделена распределителем построителя: по
+умолчанию это куча, и она освобождается через free. */
+char* s21_strbuf_detach(s21_strbuf* buf) {
+  char* data = buf->data;
+  strbuf_clear(buf);
+  return data;
+}